@@ -51,11 +51,12 @@ class Camera {
     constexpr const auto &orientation() const { return m_orientation; }
 
     constexpr auto ray(auto coord_u, auto coord_v, auto &generator) const {
-        auto viewport_height = 2.0 * std::tan(m_vertical_fov / 2.0);
+        auto viewport_height = 2.0 * coex::math::tan(m_vertical_fov / 2.0);
         auto viewport_width = viewport_height * m_aspect_ratio;
         auto coord_x = coex::math::lerp(coord_u, 0.0, 1.0, -viewport_width / 2.0, viewport_width / 2.0);
         auto coord_y = coex::math::lerp(coord_v, 0.0, 1.0, -viewport_height / 2.0, viewport_height / 2.0);
-        auto target = m_position + m_orientation % Vector<Scalar, 3>{coord_x, coord_y, 1.0} * m_focus_distance;
+        Vector<Scalar, 3> viewport_position{static_cast<Scalar>(coord_x), static_cast<Scalar>(coord_y), 1.0};
+        auto target = m_position + m_orientation % viewport_position * m_focus_distance;
         auto defocus = coex::random::uniform_in_unit_circle<Scalar, Vector>(generator) * m_aperture_radius;
         auto position = m_position + m_orientation % defocus;
         auto direction = coex::tensor::normalized(target - position);
@@ -1,4 +1,5 @@
 #include "common/algorithm.hpp"
 #include "common/functional.hpp"
 #include "common/iostream.hpp"
+#include "common/memory.hpp"
 #include "common/type_traits.hpp"
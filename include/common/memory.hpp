@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace coex {
+
+// Allocator handing out storage aligned to `Alignment` bytes (a cache line by default), e.g. for SIMD loads.
+template <typename T, std::size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    constexpr AlignedAllocator() = default;
+
+    template <typename U>
+    constexpr AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+    auto allocate(std::size_t size) {
+        return static_cast<T *>(::operator new(sizeof(T) * size, std::align_val_t(Alignment)));
+    }
+
+    auto deallocate(T *pointer, std::size_t) { ::operator delete(pointer, std::align_val_t(Alignment)); }
+
+    template <typename U>
+    constexpr auto operator==(const AlignedAllocator<U, Alignment> &) const {
+        return true;
+    }
+};
+
+template <typename T, std::size_t Alignment = 64>
+using AlignedVector = std::vector<T, AlignedAllocator<T, Alignment>>;
+
+}  // namespace coex
@@ -1,2 +1,9 @@
+#include "geometry/arena.hpp"
+#include "geometry/bounds.hpp"
+#include "geometry/bvh.hpp"
 #include "geometry/csg.hpp"
+#include "geometry/distance_cache.hpp"
+#include "geometry/hit.hpp"
+#include "geometry/materials.hpp"
+#include "geometry/packet.hpp"
 #include "geometry/sphere.hpp"
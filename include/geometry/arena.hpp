@@ -0,0 +1,282 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#include "common.hpp"
+#include "csg.hpp"
+#include "hit.hpp"
+#include "packet.hpp"
+#include "sphere.hpp"
+#include "tensor.hpp"
+
+namespace coex::geometry {
+
+// Spheres of a union-only CSG tree flattened into a structure-of-arrays arena, so that one ray can be tested against
+// a whole block of spheres with vector loads. Spheres keep their leaf order, so hits carry the indices of the tree.
+template <typename Scalar, template <typename, auto> typename Vector = coex::tensor::Vector>
+class SphereArena {
+   public:
+    // number of spheres tested per iteration of the nearest-hit kernel; the arrays are padded to a multiple of it
+    static constexpr std::size_t block_size = 8;
+
+    static constexpr auto npos = std::numeric_limits<std::size_t>::max();
+
+    SphereArena() = default;
+
+    explicit SphereArena(const auto &object) {
+        for_each_primitive(object, [this](const auto &sphere) { add(sphere); });
+        // Padding spheres have NaN centers, so every comparison against them fails and they are never hit.
+        while (m_radii.size() % block_size) {
+            for (auto &centers : m_centers) centers.push_back(std::numeric_limits<Scalar>::quiet_NaN());
+            m_radii.push_back(std::numeric_limits<Scalar>::quiet_NaN());
+        }
+    }
+
+    auto size() const { return m_size; }
+
+    const auto &centers() const { return m_centers; }
+    const auto &radii() const { return m_radii; }
+
+    // Index of and distance to the nearest sphere hit by the ray (`npos` and infinity on a miss).
+    auto nearest(const auto &ray) const -> std::tuple<std::size_t, Scalar> {
+        const auto &position = ray.position();
+        const auto &direction = ray.direction();
+        auto a = coex::tensor::dot(direction, direction);
+
+#if defined(__AVX512F__)
+        if constexpr (std::is_same_v<Scalar, double>) {
+            auto dx = _mm512_set1_pd(direction[0]);
+            auto dy = _mm512_set1_pd(direction[1]);
+            auto dz = _mm512_set1_pd(direction[2]);
+            auto px = _mm512_set1_pd(position[0]), py = _mm512_set1_pd(position[1]), pz = _mm512_set1_pd(position[2]);
+            auto va = _mm512_set1_pd(a);
+            auto zero = _mm512_setzero_pd();
+            auto minus_one = _mm512_set1_pd(-1.0);
+            auto tolerance = _mm512_set1_pd(sphere_tolerance<Scalar>);
+            // zero-masked sqrt, min and max over all the lanes, as the unmasked ones pass an undefined vector through
+            constexpr __mmask8 lanes = 0xff;
+            auto nearest = _mm512_set1_pd(std::numeric_limits<Scalar>::infinity());
+            auto indices = _mm512_setzero_pd();
+            auto index = _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7);
+            for (std::size_t offset = 0; offset < m_radii.size(); offset += block_size) {
+                auto ox = _mm512_sub_pd(px, _mm512_load_pd(m_centers[0].data() + offset));
+                auto oy = _mm512_sub_pd(py, _mm512_load_pd(m_centers[1].data() + offset));
+                auto oz = _mm512_sub_pd(pz, _mm512_load_pd(m_centers[2].data() + offset));
+                auto radius = _mm512_load_pd(m_radii.data() + offset);
+                auto squared_radius = _mm512_mul_pd(radius, radius);
+                auto b = _mm512_fmadd_pd(dz, oz, _mm512_fmadd_pd(dy, oy, _mm512_mul_pd(dx, ox)));
+                auto squared_norm = _mm512_fmadd_pd(oz, oz, _mm512_fmadd_pd(oy, oy, _mm512_mul_pd(ox, ox)));
+                auto c = _mm512_sub_pd(squared_norm, squared_radius);
+                auto k = _mm512_div_pd(b, va);
+                auto lx = _mm512_fnmadd_pd(k, dx, ox);
+                auto ly = _mm512_fnmadd_pd(k, dy, oy);
+                auto lz = _mm512_fnmadd_pd(k, dz, oz);
+                auto d = _mm512_mul_pd(
+                    va, _mm512_sub_pd(squared_radius,
+                                      _mm512_fmadd_pd(lz, lz, _mm512_fmadd_pd(ly, ly, _mm512_mul_pd(lx, lx)))));
+                auto root = _mm512_maskz_sqrt_pd(lanes, _mm512_maskz_max_pd(lanes, d, zero));
+                root = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(b, zero, _CMP_LT_OQ), root,
+                                            _mm512_mul_pd(root, minus_one));
+                auto q = _mm512_mul_pd(_mm512_add_pd(b, root), minus_one);
+                auto leaving = _mm512_cmp_pd_mask(_mm512_abs_pd(c), _mm512_mul_pd(tolerance, squared_norm),
+                                                  _CMP_LE_OQ);
+                auto distance_1 = _mm512_mask_blend_pd(leaving, _mm512_div_pd(c, q),
+                                                       _mm512_set1_pd(-std::numeric_limits<Scalar>::infinity()));
+                auto distance_2 = _mm512_div_pd(q, va);
+                auto near = _mm512_maskz_min_pd(lanes, distance_1, distance_2);
+                auto far = _mm512_maskz_max_pd(lanes, distance_1, distance_2);
+                auto distance = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(near, zero, _CMP_GT_OQ), far, near);
+                auto mask = _mm512_cmp_pd_mask(d, zero, _CMP_GE_OQ) &
+                            _mm512_cmp_pd_mask(distance, zero, _CMP_GT_OQ) &
+                            _mm512_cmp_pd_mask(distance, nearest, _CMP_LT_OQ);
+                nearest = _mm512_mask_blend_pd(mask, nearest, distance);
+                indices = _mm512_mask_blend_pd(mask, indices, index);
+                index = _mm512_add_pd(index, _mm512_set1_pd(block_size));
+            }
+            alignas(64) std::array<Scalar, block_size> distances, lane_indices;
+            _mm512_store_pd(distances.data(), nearest);
+            _mm512_store_pd(lane_indices.data(), indices);
+            return reduce(distances, lane_indices);
+        }
+#elif defined(__AVX__)
+        if constexpr (std::is_same_v<Scalar, double>) {
+            // two halves of four spheres each
+            auto dx = _mm256_set1_pd(direction[0]);
+            auto dy = _mm256_set1_pd(direction[1]);
+            auto dz = _mm256_set1_pd(direction[2]);
+            auto px = _mm256_set1_pd(position[0]), py = _mm256_set1_pd(position[1]), pz = _mm256_set1_pd(position[2]);
+            auto va = _mm256_set1_pd(a);
+            auto zero = _mm256_setzero_pd();
+            auto minus_one = _mm256_set1_pd(-1.0);
+            auto tolerance = _mm256_set1_pd(sphere_tolerance<Scalar>);
+            // mask of the sign bits, cleared for absolute values
+            auto sign = _mm256_set1_pd(-0.0);
+            __m256d nearest[2] = {_mm256_set1_pd(std::numeric_limits<Scalar>::infinity()),
+                                  _mm256_set1_pd(std::numeric_limits<Scalar>::infinity())};
+            __m256d indices[2] = {zero, zero};
+            __m256d index[2] = {_mm256_setr_pd(0, 1, 2, 3), _mm256_setr_pd(4, 5, 6, 7)};
+            for (std::size_t offset = 0; offset < m_radii.size(); offset += block_size) {
+                for (std::size_t half = 0; half < 2; ++half) {
+                    auto ox = _mm256_sub_pd(px, _mm256_load_pd(m_centers[0].data() + offset + 4 * half));
+                    auto oy = _mm256_sub_pd(py, _mm256_load_pd(m_centers[1].data() + offset + 4 * half));
+                    auto oz = _mm256_sub_pd(pz, _mm256_load_pd(m_centers[2].data() + offset + 4 * half));
+                    auto radius = _mm256_load_pd(m_radii.data() + offset + 4 * half);
+                    auto squared_radius = _mm256_mul_pd(radius, radius);
+                    auto b = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, ox), _mm256_mul_pd(dy, oy)),
+                                           _mm256_mul_pd(dz, oz));
+                    auto squared_norm = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(ox, ox), _mm256_mul_pd(oy, oy)),
+                                                      _mm256_mul_pd(oz, oz));
+                    auto c = _mm256_sub_pd(squared_norm, squared_radius);
+                    auto k = _mm256_div_pd(b, va);
+                    auto lx = _mm256_sub_pd(ox, _mm256_mul_pd(k, dx));
+                    auto ly = _mm256_sub_pd(oy, _mm256_mul_pd(k, dy));
+                    auto lz = _mm256_sub_pd(oz, _mm256_mul_pd(k, dz));
+                    auto d = _mm256_mul_pd(
+                        va, _mm256_sub_pd(squared_radius,
+                                          _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(lx, lx), _mm256_mul_pd(ly, ly)),
+                                                        _mm256_mul_pd(lz, lz))));
+                    auto root = _mm256_sqrt_pd(_mm256_max_pd(d, zero));
+                    root = _mm256_blendv_pd(root, _mm256_mul_pd(root, minus_one), _mm256_cmp_pd(b, zero, _CMP_LT_OQ));
+                    auto q = _mm256_mul_pd(_mm256_add_pd(b, root), minus_one);
+                    auto leaving = _mm256_cmp_pd(_mm256_andnot_pd(sign, c), _mm256_mul_pd(tolerance, squared_norm),
+                                                 _CMP_LE_OQ);
+                    auto distance_1 = _mm256_blendv_pd(
+                        _mm256_div_pd(c, q), _mm256_set1_pd(-std::numeric_limits<Scalar>::infinity()), leaving);
+                    auto distance_2 = _mm256_div_pd(q, va);
+                    auto near = _mm256_min_pd(distance_1, distance_2);
+                    auto far = _mm256_max_pd(distance_1, distance_2);
+                    auto distance = _mm256_blendv_pd(far, near, _mm256_cmp_pd(near, zero, _CMP_GT_OQ));
+                    auto mask = _mm256_and_pd(
+                        _mm256_and_pd(_mm256_cmp_pd(d, zero, _CMP_GE_OQ), _mm256_cmp_pd(distance, zero, _CMP_GT_OQ)),
+                        _mm256_cmp_pd(distance, nearest[half], _CMP_LT_OQ));
+                    nearest[half] = _mm256_blendv_pd(nearest[half], distance, mask);
+                    indices[half] = _mm256_blendv_pd(indices[half], index[half], mask);
+                    index[half] = _mm256_add_pd(index[half], _mm256_set1_pd(block_size));
+                }
+            }
+            alignas(64) std::array<Scalar, block_size> distances, lane_indices;
+            _mm256_store_pd(distances.data(), nearest[0]);
+            _mm256_store_pd(distances.data() + 4, nearest[1]);
+            _mm256_store_pd(lane_indices.data(), indices[0]);
+            _mm256_store_pd(lane_indices.data() + 4, indices[1]);
+            return reduce(distances, lane_indices);
+        }
+#endif
+        // portable fallback, laid out lane by lane for the auto-vectorizer
+        std::array<Scalar, block_size> distances, lane_indices{};
+        distances.fill(std::numeric_limits<Scalar>::infinity());
+        for (std::size_t offset = 0; offset < m_radii.size(); offset += block_size) {
+            for (std::size_t lane = 0; lane < block_size; ++lane) {
+                auto ox = position[0] - m_centers[0][offset + lane];
+                auto oy = position[1] - m_centers[1][offset + lane];
+                auto oz = position[2] - m_centers[2][offset + lane];
+                auto radius = m_radii[offset + lane];
+                auto b = direction[0] * ox + direction[1] * oy + direction[2] * oz;
+                auto squared_norm = ox * ox + oy * oy + oz * oz;
+                auto c = squared_norm - radius * radius;
+                auto k = b / a;
+                auto lx = ox - k * direction[0], ly = oy - k * direction[1], lz = oz - k * direction[2];
+                auto d = a * (radius * radius - (lx * lx + ly * ly + lz * lz));
+                auto root = std::sqrt(std::max(d, Scalar(0)));
+                auto q = -(b + (b < 0 ? -root : root));
+                auto distance_1 = std::abs(c) <= sphere_tolerance<Scalar> * squared_norm
+                                      ? -std::numeric_limits<Scalar>::infinity()
+                                      : c / q;
+                auto distance_2 = q / a;
+                auto near = distance_1 < distance_2 ? distance_1 : distance_2;
+                auto far = distance_1 > distance_2 ? distance_1 : distance_2;
+                auto distance = near > 0 ? near : far;
+                auto hit = d >= 0 && distance > 0 && distance < distances[lane];
+                distances[lane] = hit ? distance : distances[lane];
+                lane_indices[lane] = hit ? Scalar(offset + lane) : lane_indices[lane];
+            }
+        }
+        return reduce(distances, lane_indices);
+    }
+
+    // Same contract as CSG::intersect, so that the arena can stand in for the tree it was built from.
+    auto intersect(const auto &ray) const {
+        auto [index, distance] = nearest(ray);
+        if (index == npos) return Hit<Scalar>{};
+        return Hit<Scalar>{distance, static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(index)};
+    }
+
+    // Intersect a packet of rays at once, keeping the nearer hits, as CSG::intersect does. Every sphere is tested
+    // against all the lanes in SIMD.
+    template <std::size_t Width>
+    auto intersect(const RayPacket<Scalar, Width, Vector> &packet, auto &hit) const {
+        for (std::size_t sphere = 0; sphere < size(); ++sphere) {
+            std::array<Scalar, 3> center{m_centers[0][sphere], m_centers[1][sphere], m_centers[2][sphere]};
+            for (auto mask = intersect_sphere(center, m_radii[sphere], packet, hit.distances); mask; mask &= mask - 1) {
+                hit.primitives[std::countr_zero(mask)] = static_cast<std::uint32_t>(sphere);
+                hit.materials[std::countr_zero(mask)] = static_cast<std::uint32_t>(sphere);
+            }
+        }
+    }
+
+    // Same contract as CSG::distance for a union.
+    auto distance(const auto &position) const {
+        auto nearest = std::numeric_limits<Scalar>::infinity();
+        std::size_t index = 0;
+        for (std::size_t sphere = 0; sphere < size(); ++sphere) {
+            auto dx = position[0] - m_centers[0][sphere];
+            auto dy = position[1] - m_centers[1][sphere];
+            auto dz = position[2] - m_centers[2][sphere];
+            auto distance = std::sqrt(dx * dx + dy * dy + dz * dz) - m_radii[sphere];
+            index = distance < nearest ? sphere : index;
+            nearest = distance < nearest ? distance : nearest;
+        }
+        if (!size()) return Hit<Scalar>{};
+        return Hit<Scalar>{nearest, static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(index)};
+    }
+
+    auto normal(std::uint32_t primitive, const auto &position) const {
+        return (position - Vector<Scalar, 3>{m_centers[0][primitive], m_centers[1][primitive],
+                                             m_centers[2][primitive]}) /
+               m_radii[primitive];
+    }
+
+   private:
+    // Only spheres can be added, so that unions of anything else fail to compile.
+    template <template <typename, template <typename, auto> typename> typename Material>
+    auto add(const Sphere<Scalar, Vector, Material> &sphere) {
+        for (auto component = 0; component < 3; ++component) {
+            m_centers[component].push_back(sphere.position()[component]);
+        }
+        m_radii.push_back(sphere.radius());
+        ++m_size;
+    }
+
+    // Pick the nearest of the per-lane minima; ties go to the sphere that comes first.
+    static auto reduce(const std::array<Scalar, block_size> &distances,
+                       const std::array<Scalar, block_size> &indices) -> std::tuple<std::size_t, Scalar> {
+        auto nearest = std::numeric_limits<Scalar>::infinity();
+        auto index = npos;
+        for (std::size_t lane = 0; lane < block_size; ++lane) {
+            auto tie = distances[lane] == nearest && index != npos && static_cast<std::size_t>(indices[lane]) < index;
+            if (distances[lane] < nearest || tie) {
+                nearest = distances[lane];
+                index = static_cast<std::size_t>(indices[lane]);
+            }
+        }
+        return {index, nearest};
+    }
+
+    std::array<coex::AlignedVector<Scalar>, 3> m_centers;
+    coex::AlignedVector<Scalar> m_radii;
+    std::size_t m_size = 0;
+};
+
+}  // namespace coex::geometry
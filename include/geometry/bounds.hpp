@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace coex::geometry {
+
+// Axis-aligned bounding box; the default one is empty.
+template <typename Scalar>
+struct AABB {
+    std::array<Scalar, 3> lower{std::numeric_limits<Scalar>::infinity(), std::numeric_limits<Scalar>::infinity(),
+                                std::numeric_limits<Scalar>::infinity()};
+    std::array<Scalar, 3> upper{-std::numeric_limits<Scalar>::infinity(), -std::numeric_limits<Scalar>::infinity(),
+                                -std::numeric_limits<Scalar>::infinity()};
+
+    constexpr auto extend(const AABB &other) {
+        for (auto axis = 0; axis < 3; ++axis) {
+            lower[axis] = std::min(lower[axis], other.lower[axis]);
+            upper[axis] = std::max(upper[axis], other.upper[axis]);
+        }
+    }
+
+    constexpr auto extend(const auto &point) {
+        for (auto axis = 0; axis < 3; ++axis) {
+            lower[axis] = std::min<Scalar>(lower[axis], point[axis]);
+            upper[axis] = std::max<Scalar>(upper[axis], point[axis]);
+        }
+    }
+
+    constexpr auto empty() const { return lower[0] > upper[0]; }
+
+    constexpr auto extent(auto axis) const { return upper[axis] - lower[axis]; }
+
+    constexpr auto center(auto axis) const { return (lower[axis] + upper[axis]) / 2; }
+
+    // half of the surface area, which is all the surface area heuristic needs
+    constexpr auto half_area() const -> Scalar {
+        if (empty()) return 0;
+        return extent(0) * extent(1) + extent(1) * extent(2) + extent(2) * extent(0);
+    }
+};
+
+}  // namespace coex::geometry
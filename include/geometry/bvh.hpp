@@ -0,0 +1,561 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "bounds.hpp"
+#include "csg.hpp"
+#include "hit.hpp"
+#include "packet.hpp"
+#include "sphere.hpp"
+#include "tensor.hpp"
+
+namespace coex::geometry {
+
+// A node of a bounding volume hierarchy packed into 32 bytes. The bounds are stored in single precision, rounded
+// outwards so that they still enclose the primitives. The first child of an interior node follows it directly.
+struct alignas(32) BVHNode {
+    std::array<float, 3> lower;
+    std::array<float, 3> upper;
+    std::uint32_t offset;  // first primitive of a leaf, or second child of an interior node
+    std::uint16_t count;   // number of primitives of a leaf, zero for an interior node
+    std::uint16_t axis;    // split axis of an interior node
+
+    constexpr auto leaf() const { return count != 0; }
+};
+
+static_assert(sizeof(BVHNode) == 32);
+
+// Work done by the nearest-hit queries of a hierarchy, counted when profiling (see `profiled`).
+struct TraversalCounters {
+    std::size_t num_node_visits = 0;
+    std::size_t num_primitive_tests = 0;
+};
+
+// Bounding volume hierarchy over the leaves of a union-only CSG tree, built with the binned surface area heuristic
+// and traversed near child first, skipping every subtree that starts beyond the nearest hit found so far.
+// With a fixed number of primitives, the tables are std::arrays that can be built at compile time and embedded in the
+// binary (see construct_bvh); the node table is then sized for the largest possible tree of 2n - 1 nodes.
+template <typename Scalar, template <typename, auto> typename Vector = coex::tensor::Vector,
+          std::size_t NumPrimitives = std::dynamic_extent>
+class BVH {
+    static constexpr auto dynamic = NumPrimitives == std::dynamic_extent;
+
+    using Nodes = std::conditional_t<dynamic, std::vector<BVHNode>,
+                                     std::array<BVHNode, std::max<std::size_t>(2 * NumPrimitives, 2) - 1>>;
+    using Primitives = std::conditional_t<dynamic, std::vector<Geometry<Scalar, Vector>>,
+                                          std::array<Geometry<Scalar, Vector>, NumPrimitives>>;
+    using Materials =
+        std::conditional_t<dynamic, std::vector<std::uint32_t>, std::array<std::uint32_t, NumPrimitives>>;
+
+   public:
+    static constexpr std::size_t num_bins = 12;
+    static constexpr std::size_t max_leaf_size = 4;
+    // bounds the depth of the tree and thereby the traversal stack
+    static constexpr std::size_t max_depth = 64;
+    // cost of visiting a node relative to intersecting a primitive
+    static constexpr Scalar traversal_cost = 1.0;
+
+    static_assert(max_leaf_size <= std::numeric_limits<decltype(BVHNode::count)>::max());
+
+    static constexpr auto npos = std::numeric_limits<std::size_t>::max();
+
+    constexpr BVH() = default;
+
+    constexpr explicit BVH(const auto &object)
+        requires dynamic
+        : BVH(flatten(object)) {}
+
+    // Scenes assembled at runtime can hand over their primitives directly; their material IDs are their indices.
+    constexpr explicit BVH(std::vector<Geometry<Scalar, Vector>> primitives)
+        requires dynamic
+        : m_primitives(std::move(primitives)) {
+        std::vector<Reference> references;
+        for (std::size_t index = 0; index < m_primitives.size(); ++index) {
+            auto bounds = std::visit([](const auto &primitive) { return primitive.bounds(); }, m_primitives[index]);
+            references.push_back({bounds, {bounds.center(0), bounds.center(1), bounds.center(2)}, index});
+        }
+        if (!references.empty()) build(references, 0, references.size(), 0);
+
+        // store the primitives in leaf order
+        std::vector<Geometry<Scalar, Vector>> sorted_primitives;
+        for (const auto &reference : references) {
+            sorted_primitives.push_back(std::move(m_primitives[reference.index]));
+            m_materials.push_back(static_cast<std::uint32_t>(reference.index));
+        }
+        m_primitives = std::move(sorted_primitives);
+    }
+
+    // copy of a hierarchy into fixed-size tables
+    constexpr explicit BVH(const BVH<Scalar, Vector> &bvh)
+        requires(!dynamic)
+        : m_num_nodes(bvh.nodes().size()) {
+        std::copy(std::begin(bvh.nodes()), std::end(bvh.nodes()), std::begin(m_nodes));
+        std::copy(std::begin(bvh.primitives()), std::end(bvh.primitives()), std::begin(m_primitives));
+        std::copy(std::begin(bvh.materials()), std::end(bvh.materials()), std::begin(m_materials));
+    }
+
+    constexpr auto nodes() const { return std::span<const BVHNode>(std::data(m_nodes), num_nodes()); }
+    constexpr auto primitives() const { return std::span<const Geometry<Scalar, Vector>>(m_primitives); }
+    constexpr auto materials() const { return std::span<const std::uint32_t>(m_materials); }
+
+    // Index of and distance to the nearest primitive hit by the ray (`npos` and infinity on a miss). The work done is
+    // added to the counters, if any.
+    template <typename Counters = std::nullptr_t>
+        requires std::is_null_pointer_v<Counters> || std::is_same_v<Counters, TraversalCounters *>
+    constexpr auto nearest(const auto &ray, Counters counters = nullptr) const -> std::tuple<std::size_t, Scalar> {
+        constexpr auto counted = !std::is_null_pointer_v<Counters>;
+
+        const auto &position = ray.position();
+        const auto &direction = ray.direction();
+
+        std::array<Scalar, 3> inverse;
+        for (auto axis = 0; axis < 3; ++axis) {
+            inverse[axis] = 1 / (direction[axis] != 0 ? direction[axis] : Scalar(1e-30));
+        }
+
+        auto nearest = std::numeric_limits<Scalar>::infinity();
+        auto index = npos;
+
+        // distance at which the ray enters the node, or infinity if it misses the node or enters beyond `nearest`
+        auto entry = [&](const BVHNode &node) constexpr {
+            Scalar near = 0;
+            Scalar far = nearest;
+            for (auto axis = 0; axis < 3; ++axis) {
+                auto distance_1 = (node.lower[axis] - position[axis]) * inverse[axis];
+                auto distance_2 = (node.upper[axis] - position[axis]) * inverse[axis];
+                if (distance_1 > distance_2) std::swap(distance_1, distance_2);
+                // widen the slab by a few ulps so that rounding never culls a grazing hit
+                distance_2 += (distance_2 < 0 ? -distance_2 : distance_2) * 4 *
+                              std::numeric_limits<Scalar>::epsilon();
+                near = std::max(near, distance_1);
+                far = std::min(far, distance_2);
+            }
+            return near <= far ? near : std::numeric_limits<Scalar>::infinity();
+        };
+
+        if (!num_nodes() || !(entry(m_nodes.front()) < std::numeric_limits<Scalar>::infinity())) {
+            return {index, nearest};
+        }
+
+        std::array<std::tuple<std::uint32_t, Scalar>, max_depth> stack;
+        std::size_t stack_size = 0;
+        std::uint32_t node_index = 0;
+        while (true) {
+            const auto &node = m_nodes[node_index];
+            if constexpr (counted) ++counters->num_node_visits;
+            if (node.leaf()) {
+                for (auto primitive_index = node.offset; primitive_index < node.offset + node.count;
+                     ++primitive_index) {
+                    if constexpr (counted) ++counters->num_primitive_tests;
+                    auto distance = std::visit(
+                        [&](const auto &primitive) { return primitive.intersect_distance(ray); },
+                        m_primitives[primitive_index]);
+                    if (distance && distance.value() < nearest) {
+                        nearest = distance.value();
+                        index = primitive_index;
+                    }
+                }
+            } else {
+                std::uint32_t child_1 = node_index + 1;
+                std::uint32_t child_2 = node.offset;
+                auto entry_1 = entry(m_nodes[child_1]);
+                auto entry_2 = entry(m_nodes[child_2]);
+                if (entry_2 < entry_1) {
+                    std::swap(child_1, child_2);
+                    std::swap(entry_1, entry_2);
+                }
+                if (entry_1 < std::numeric_limits<Scalar>::infinity()) {
+                    if (entry_2 < std::numeric_limits<Scalar>::infinity()) stack[stack_size++] = {child_2, entry_2};
+                    node_index = child_1;
+                    continue;
+                }
+            }
+
+            // resume with the next deferred node that may still hold a nearer hit
+            Scalar distance;
+            do {
+                if (!stack_size) return {index, nearest};
+                std::tie(node_index, distance) = stack[--stack_size];
+            } while (distance > nearest);
+        }
+    }
+
+    // Same contract as CSG::intersect, so that the hierarchy can stand in for the tree it was built from. Primitives
+    // are numbered in leaf order, while material IDs stay those of the tree.
+    template <typename Counters = std::nullptr_t>
+        requires std::is_null_pointer_v<Counters> || std::is_same_v<Counters, TraversalCounters *>
+    constexpr auto intersect(const auto &ray, Counters counters = nullptr) const {
+        auto [index, distance] = nearest(ray, counters);
+        if (index == npos) return Hit<Scalar>{};
+        return Hit<Scalar>{distance, static_cast<std::uint32_t>(index), m_materials[index]};
+    }
+
+    // Intersect a packet of rays at once, keeping the nearer hits, as CSG::intersect does. The packet goes down the
+    // hierarchy as a whole with the mask of its lanes that enter each node, into the child that one of them enters
+    // first, and a deferred node is resumed only by the lanes that may still find a nearer hit in it. Leaves test their
+    // primitives against every lane in SIMD, as any hit found on a lane is a real one.
+    template <std::size_t Width>
+    auto intersect(const RayPacket<Scalar, Width, Vector> &packet, auto &hit) const {
+        using Entries = std::array<Scalar, Width>;
+
+        std::array<Entries, 3> inverses;
+        for (auto axis = 0; axis < 3; ++axis) {
+            for (std::size_t lane = 0; lane < Width; ++lane) {
+                auto direction = packet.directions[axis][lane];
+                inverses[axis][lane] = 1 / (direction != 0 ? direction : Scalar(1e-30));
+            }
+        }
+
+        // hits numbered in leaf order, until they are merged into the packet's hits at the end
+        auto nearest = hit;
+
+        // Distances at which the lanes enter the node, as in `nearest`, and the mask of the lanes of `mask` that do.
+        // The slabs are tested axis by axis over all the lanes, without branches, for the auto-vectorizer.
+        auto entry = [&](const BVHNode &node, std::uint32_t mask, Entries &entries) {
+            Entries nears{};
+            auto fars = nearest.distances;
+            for (auto axis = 0; axis < 3; ++axis) {
+                for (std::size_t lane = 0; lane < Width; ++lane) {
+                    auto distance_1 = (node.lower[axis] - packet.positions[axis][lane]) * inverses[axis][lane];
+                    auto distance_2 = (node.upper[axis] - packet.positions[axis][lane]) * inverses[axis][lane];
+                    auto near = distance_1 < distance_2 ? distance_1 : distance_2;
+                    auto far = distance_1 < distance_2 ? distance_2 : distance_1;
+                    far += (far < 0 ? -far : far) * 4 * std::numeric_limits<Scalar>::epsilon();
+                    nears[lane] = nears[lane] < near ? near : nears[lane];
+                    fars[lane] = far < fars[lane] ? far : fars[lane];
+                }
+            }
+            std::uint32_t entered = 0;
+            for (std::size_t lane = 0; lane < Width; ++lane) {
+                entries[lane] = nears[lane] <= fars[lane] ? nears[lane] : std::numeric_limits<Scalar>::infinity();
+                entered |= std::uint32_t{nears[lane] <= fars[lane]} << lane;
+            }
+            return entered & mask;
+        };
+        auto first_entry = [](const Entries &entries, std::uint32_t mask) {
+            auto first = std::numeric_limits<Scalar>::infinity();
+            for (; mask; mask &= mask - 1) first = std::min(first, entries[std::countr_zero(mask)]);
+            return first;
+        };
+
+        auto traverse = [&]() {
+            struct Deferred {
+                std::uint32_t node_index;
+                std::uint32_t mask;
+                Entries entries;
+            };
+
+            Entries entries;
+            auto mask = num_nodes() ? entry(m_nodes.front(), packet.mask, entries) : 0;
+            if (!mask) return;
+
+            std::array<Deferred, max_depth> stack;
+            std::size_t stack_size = 0;
+            std::uint32_t node_index = 0;
+            while (true) {
+                const auto &node = m_nodes[node_index];
+                if (node.leaf()) {
+                    for (auto primitive_index = node.offset; primitive_index < node.offset + node.count;
+                         ++primitive_index) {
+                        std::visit(
+                            [&](const auto &primitive) { primitive.intersect(packet, nearest, primitive_index); },
+                            m_primitives[primitive_index]);
+                    }
+                } else {
+                    std::uint32_t child_1 = node_index + 1;
+                    std::uint32_t child_2 = node.offset;
+                    Entries entries_1, entries_2;
+                    auto mask_1 = entry(m_nodes[child_1], mask, entries_1);
+                    auto mask_2 = entry(m_nodes[child_2], mask, entries_2);
+                    if (first_entry(entries_2, mask_2) < first_entry(entries_1, mask_1)) {
+                        std::swap(child_1, child_2);
+                        std::swap(mask_1, mask_2);
+                        std::swap(entries_1, entries_2);
+                    }
+                    if (mask_1) {
+                        if (mask_2) stack[stack_size++] = {child_2, mask_2, entries_2};
+                        node_index = child_1;
+                        mask = mask_1;
+                        continue;
+                    }
+                }
+
+                // resume with the next deferred node that may still hold a nearer hit for some lane
+                do {
+                    if (!stack_size) return;
+                    const auto &deferred = stack[--stack_size];
+                    node_index = deferred.node_index;
+                    mask = 0;
+                    for (auto lanes = deferred.mask; lanes; lanes &= lanes - 1) {
+                        auto lane = std::countr_zero(lanes);
+                        if (!(deferred.entries[lane] > nearest.distances[lane])) mask |= std::uint32_t{1} << lane;
+                    }
+                } while (!mask);
+            }
+        };
+        traverse();
+
+        for (auto lanes = packet.mask; lanes; lanes &= lanes - 1) {
+            auto lane = std::countr_zero(lanes);
+            if (nearest.distances[lane] < hit.distances[lane]) {
+                auto primitive = nearest.primitives[lane];
+                hit.set(lane, Hit<Scalar>{nearest.distances[lane], primitive, m_materials[primitive]});
+            }
+        }
+    }
+
+    // Same contract as CSG::distance for a union. Subtrees whose bounds lie farther than the nearest surface found so
+    // far are skipped; a point inside a box may still be inside one of its primitives, so those are always visited.
+    constexpr auto distance(const auto &position) const {
+        auto nearest = std::numeric_limits<Scalar>::infinity();
+        auto index = npos;
+
+        auto squared_distance = [&](const BVHNode &node) constexpr {
+            Scalar squared_distance = 0;
+            for (auto axis = 0; axis < 3; ++axis) {
+                auto distance =
+                    std::max<Scalar>({node.lower[axis] - position[axis], 0, position[axis] - node.upper[axis]});
+                squared_distance += distance * distance;
+            }
+            return squared_distance;
+        };
+        auto skip = [&](const BVHNode &node) constexpr {
+            auto distance = squared_distance(node);
+            return distance > 0 && (nearest <= 0 || distance > nearest * nearest);
+        };
+
+        std::array<std::uint32_t, max_depth + 1> stack;
+        std::size_t stack_size = 0;
+        if (num_nodes()) stack[stack_size++] = 0;
+        while (stack_size) {
+            auto node_index = stack[--stack_size];
+            const auto &node = m_nodes[node_index];
+            if (skip(node)) continue;
+            if (node.leaf()) {
+                for (auto primitive_index = node.offset; primitive_index < node.offset + node.count;
+                     ++primitive_index) {
+                    auto distance = std::visit(
+                        [&](const auto &primitive) { return primitive.distance(position).distance; },
+                        m_primitives[primitive_index]);
+                    if (distance < nearest) {
+                        nearest = distance;
+                        index = primitive_index;
+                    }
+                }
+            } else {
+                // visit the nearer child first, so that the farther one is more likely to be skipped
+                std::uint32_t child_1 = node_index + 1;
+                std::uint32_t child_2 = node.offset;
+                if (squared_distance(m_nodes[child_2]) < squared_distance(m_nodes[child_1])) {
+                    std::swap(child_1, child_2);
+                }
+                stack[stack_size++] = child_2;
+                stack[stack_size++] = child_1;
+            }
+        }
+
+        if (index == npos) return Hit<Scalar>{};
+        return Hit<Scalar>{nearest, static_cast<std::uint32_t>(index), m_materials[index]};
+    }
+
+    constexpr auto normal(std::uint32_t primitive, const auto &position) const {
+        return std::visit([&](const auto &primitive) { return primitive.normal(position); }, m_primitives[primitive]);
+    }
+
+   private:
+    constexpr auto num_nodes() const -> std::size_t {
+        if constexpr (dynamic) {
+            return m_nodes.size();
+        } else {
+            return m_num_nodes;
+        }
+    }
+
+    struct Reference {
+        AABB<Scalar> bounds;
+        std::array<Scalar, 3> centroid;
+        std::size_t index;
+    };
+
+    static constexpr auto flatten(const auto &object) {
+        std::vector<Geometry<Scalar, Vector>> primitives;
+        for_each_primitive(object, [&](const auto &primitive) { primitives.emplace_back(primitive); });
+        return primitives;
+    }
+
+    // single precision bounds that enclose the double precision ones
+    static constexpr auto round_down(Scalar value) {
+        auto rounded = static_cast<float>(value);
+        if (rounded <= value) return rounded;
+        return rounded - ((rounded < 0 ? -rounded : rounded) * 0x1p-23f + std::numeric_limits<float>::denorm_min());
+    }
+
+    static constexpr auto round_up(Scalar value) {
+        auto rounded = static_cast<float>(value);
+        if (rounded >= value) return rounded;
+        return rounded + ((rounded < 0 ? -rounded : rounded) * 0x1p-23f + std::numeric_limits<float>::denorm_min());
+    }
+
+    // Build the subtree over references [begin, end) in depth-first order.
+    constexpr auto build(std::vector<Reference> &references, std::size_t begin, std::size_t end, std::size_t depth)
+        -> void {
+        AABB<Scalar> bounds;
+        AABB<Scalar> centroid_bounds;
+        for (auto index = begin; index < end; ++index) {
+            bounds.extend(references[index].bounds);
+            centroid_bounds.extend(references[index].centroid);
+        }
+
+        auto node_index = m_nodes.size();
+        BVHNode node{};
+        for (auto axis = 0; axis < 3; ++axis) {
+            node.lower[axis] = round_down(bounds.lower[axis]);
+            node.upper[axis] = round_up(bounds.upper[axis]);
+        }
+        m_nodes.push_back(node);
+
+        auto count = end - begin;
+        auto make_leaf = [&]() constexpr {
+            m_nodes[node_index].offset = static_cast<std::uint32_t>(begin);
+            m_nodes[node_index].count = static_cast<std::uint16_t>(count);
+        };
+        if (count == 1 || depth + 1 >= max_depth) return make_leaf();
+
+        // Splits by the heuristic may peel off only a few primitives at a time. Once the levels left just suffice to
+        // halve the references down to one per leaf, they are halved at the median centroid of the widest axis
+        // instead, so that no leaf is forced at the depth limit with more than one primitive and every leaf holds at
+        // most `max_leaf_size` of them.
+        if (depth + std::bit_width(count - 1) + 1 >= max_depth) {
+            std::size_t axis = 0;
+            for (std::size_t other = 1; other < 3; ++other) {
+                if (centroid_bounds.extent(other) > centroid_bounds.extent(axis)) axis = other;
+            }
+            auto middle = begin + count / 2;
+            std::nth_element(std::begin(references) + begin, std::begin(references) + middle,
+                             std::begin(references) + end,
+                             [&](const auto &reference_1, const auto &reference_2) {
+                                 return reference_1.centroid[axis] < reference_2.centroid[axis];
+                             });
+            build(references, begin, middle, depth + 1);
+            m_nodes[node_index].offset = static_cast<std::uint32_t>(m_nodes.size());
+            m_nodes[node_index].axis = static_cast<std::uint16_t>(axis);
+            build(references, middle, end, depth + 1);
+            return;
+        }
+
+        // Sweep the bin boundaries of every axis for the split of least cost.
+        auto best_cost = std::numeric_limits<Scalar>::infinity();
+        std::size_t best_axis = 0;
+        std::size_t best_bin = 0;
+        auto bin = [&](const auto &reference, auto axis) constexpr {
+            auto offset = (reference.centroid[axis] - centroid_bounds.lower[axis]) / centroid_bounds.extent(axis);
+            return std::min(num_bins - 1, static_cast<std::size_t>(offset * num_bins));
+        };
+        for (std::size_t axis = 0; axis < 3; ++axis) {
+            if (!(centroid_bounds.extent(axis) > 0)) continue;
+
+            std::array<AABB<Scalar>, num_bins> bin_bounds;
+            std::array<std::size_t, num_bins> bin_counts{};
+            for (auto index = begin; index < end; ++index) {
+                auto bin_index = bin(references[index], axis);
+                bin_bounds[bin_index].extend(references[index].bounds);
+                ++bin_counts[bin_index];
+            }
+
+            std::array<Scalar, num_bins> right_costs{};
+            AABB<Scalar> right_bounds;
+            std::size_t right_count = 0;
+            for (auto bin_index = num_bins - 1; bin_index > 0; --bin_index) {
+                right_bounds.extend(bin_bounds[bin_index]);
+                right_count += bin_counts[bin_index];
+                right_costs[bin_index] = right_bounds.half_area() * right_count;
+            }
+
+            AABB<Scalar> left_bounds;
+            std::size_t left_count = 0;
+            for (std::size_t bin_index = 0; bin_index + 1 < num_bins; ++bin_index) {
+                left_bounds.extend(bin_bounds[bin_index]);
+                left_count += bin_counts[bin_index];
+                auto cost = left_bounds.half_area() * left_count + right_costs[bin_index + 1];
+                if (left_count && left_count < count && cost < best_cost) {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_bin = bin_index;
+                }
+            }
+        }
+
+        auto area = bounds.half_area();
+        auto split_cost = traversal_cost + (area > 0 ? best_cost / area : Scalar(0));
+        if (count <= max_leaf_size && !(split_cost < count)) return make_leaf();
+
+        std::size_t middle;
+        if (best_cost < std::numeric_limits<Scalar>::infinity()) {
+            middle = std::partition(std::begin(references) + begin, std::begin(references) + end,
+                                    [&](const auto &reference) { return bin(reference, best_axis) <= best_bin; }) -
+                     std::begin(references);
+        } else {
+            // All the centroids coincide, so any halving is as good as another.
+            if (count <= max_leaf_size) return make_leaf();
+            middle = begin + count / 2;
+        }
+
+        build(references, begin, middle, depth + 1);
+        m_nodes[node_index].offset = static_cast<std::uint32_t>(m_nodes.size());
+        m_nodes[node_index].axis = static_cast<std::uint16_t>(best_axis);
+        build(references, middle, end, depth + 1);
+    }
+
+    Nodes m_nodes{};
+    Primitives m_primitives{};
+    // material ID of each primitive
+    Materials m_materials{};
+    std::size_t m_num_nodes = 0;
+};
+
+// Build the hierarchy of a constant object at compile time, e.g. `inline constexpr auto bvh = construct_bvh<object,
+// Scalar>();`.
+template <const auto &Object, typename Scalar, template <typename, auto> typename Vector = coex::tensor::Vector>
+constexpr auto construct_bvh() {
+    constexpr auto num_primitives = [] {
+        std::size_t num_primitives = 0;
+        for_each_primitive(Object, [&](const auto &) { ++num_primitives; });
+        return num_primitives;
+    }();
+    return BVH<Scalar, Vector, num_primitives>(BVH<Scalar, Vector>(Object));
+}
+
+// A hierarchy whose nearest-hit queries count their work, for profiling what they would cost when constant-evaluated.
+template <typename BVH>
+class ProfiledBVH {
+   public:
+    constexpr ProfiledBVH(const BVH &bvh, TraversalCounters &counters) : m_bvh(&bvh), m_counters(&counters) {}
+
+    constexpr auto intersect(const auto &ray) const { return m_bvh->intersect(ray, m_counters); }
+
+    constexpr auto normal(std::uint32_t primitive, const auto &position) const {
+        return m_bvh->normal(primitive, position);
+    }
+
+   private:
+    const BVH *m_bvh;
+    TraversalCounters *m_counters;
+};
+
+template <typename BVH>
+constexpr auto profiled(const BVH &bvh, TraversalCounters &counters) {
+    return ProfiledBVH<BVH>(bvh, counters);
+}
+
+}  // namespace coex::geometry
@@ -1,14 +1,34 @@
 #pragma once
 
+#include <bit>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <tuple>
+#include <type_traits>
 #include <variant>
 
 #include "camera.hpp"
 #include "common.hpp"
+#include "hit.hpp"
+#include "packet.hpp"
 
 namespace coex::geometry {
 
+struct UnionOp;
+
+template <typename Geometry1, typename Geometry2, typename Op>
+class CSG;
+
+// number of leaves of a CSG tree, i.e. of primitives it numbers
+template <typename Geometry>
+inline constexpr std::size_t num_leaves_v = 1;
+
+template <typename Geometry1, typename Geometry2, typename Op>
+inline constexpr std::size_t num_leaves_v<CSG<Geometry1, Geometry2, Op>> =
+    num_leaves_v<Geometry1> + num_leaves_v<Geometry2>;
+
 template <typename Geometry1, typename Geometry2, typename Op>
 class CSG {
    public:
@@ -20,27 +40,65 @@ class CSG {
     constexpr CSG(Geometry1 &&geometry_1, Geometry2 &&geometry_2)
         : m_geometry_1(std::move(geometry_1)), m_geometry_2(std::move(geometry_2)) {}
 
-    constexpr auto intersect(const auto &ray) const {
-        auto [geometry_1, distance_1] = m_geometry_1.intersect(ray);
-        auto [geometry_2, distance_2] = m_geometry_2.intersect(ray);
-        if (Op()(distance_1, distance_2)) {
-            return std::make_tuple(std::move(geometry_1), std::move(distance_1));
+    constexpr auto &geometry_1() { return m_geometry_1; }
+    constexpr const auto &geometry_1() const { return m_geometry_1; }
+
+    constexpr auto &geometry_2() { return m_geometry_2; }
+    constexpr const auto &geometry_2() const { return m_geometry_2; }
+
+    // The leaves of the first subtree are numbered from `first`, those of the second one right after them.
+    constexpr auto intersect(const auto &ray, std::uint32_t first = 0) const {
+        auto hit_1 = m_geometry_1.intersect(ray, first);
+        auto hit_2 = m_geometry_2.intersect(ray, first + num_leaves_v<Geometry1>);
+        if (Op()(optional_distance(hit_1), optional_distance(hit_2))) {
+            return hit_1;
+        } else {
+            return hit_2;
+        }
+    }
+
+    // Intersect a packet of rays at once, keeping the nearer hits. Unions stay in packet form all the way down, while
+    // other operations fall back to their scalar semantics lane by lane.
+    template <typename Scalar, std::size_t Width, template <typename, auto> typename Vector>
+    auto intersect(const RayPacket<Scalar, Width, Vector> &packet, auto &hit, std::uint32_t first = 0) const {
+        if constexpr (std::is_same_v<Op, UnionOp>) {
+            m_geometry_1.intersect(packet, hit, first);
+            m_geometry_2.intersect(packet, hit, first + num_leaves_v<Geometry1>);
+        } else {
+            for (auto mask = packet.mask; mask; mask &= mask - 1) {
+                auto lane = std::countr_zero(mask);
+                auto lane_hit = intersect(packet.ray(lane), first);
+                if (lane_hit && lane_hit.distance < hit.distances[lane]) hit.set(lane, lane_hit);
+            }
+        }
+    }
+
+    constexpr auto distance(const auto &position, std::uint32_t first = 0) const {
+        auto hit_1 = m_geometry_1.distance(position, first);
+        auto hit_2 = m_geometry_2.distance(position, first + num_leaves_v<Geometry1>);
+        if (Op()(hit_1.distance, hit_2.distance)) {
+            return hit_1;
         } else {
-            return std::make_tuple(std::move(geometry_2), std::move(distance_2));
+            return hit_2;
         }
     }
 
-    constexpr auto distance(const auto &position) const {
-        auto [geometry_1, distance_1] = m_geometry_1.distance(position);
-        auto [geometry_2, distance_2] = m_geometry_2.distance(position);
-        if (Op()(distance_1, distance_2)) {
-            return std::make_tuple(std::move(geometry_1), std::move(distance_1));
+    // Normal of the given leaf at a position on its surface.
+    constexpr auto normal(std::uint32_t primitive, const auto &position) const {
+        if (primitive < num_leaves_v<Geometry1>) {
+            return m_geometry_1.normal(primitive, position);
         } else {
-            return std::make_tuple(std::move(geometry_2), std::move(distance_2));
+            return m_geometry_2.normal(primitive - num_leaves_v<Geometry1>, position);
         }
     }
 
    private:
+    // the operators compare ray distances as optionals, as misses never win a union
+    template <typename Scalar>
+    static constexpr auto optional_distance(const Hit<Scalar> &hit) {
+        return hit ? std::optional<Scalar>(hit.distance) : std::nullopt;
+    }
+
     Geometry1 m_geometry_1;
     Geometry2 m_geometry_2;
 };
@@ -84,6 +142,25 @@ using Subtraction = CSG<Geometry1, Geometry2, SubtractionOp>;
 template <typename Geometry1, typename Geometry2>
 using Intersection = CSG<Geometry1, Geometry2, IntersectionOp>;
 
+// Invoke `function` on every leaf of a union-only CSG tree, from left to right. Other operators are not looked into,
+// so their CSG nodes reach `function` as they are.
+constexpr auto for_each_primitive(const auto &geometry, auto &&function) { function(geometry); }
+
+template <typename Geometry1, typename Geometry2>
+constexpr auto for_each_primitive(const Union<Geometry1, Geometry2> &csg, auto &&function) {
+    for_each_primitive(csg.geometry_1(), function);
+    for_each_primitive(csg.geometry_2(), function);
+}
+
+// Invoke `function` on every leaf of a CSG tree whatever its operators, in the order in which the leaves are numbered.
+constexpr auto for_each_leaf(const auto &geometry, auto &&function) { function(geometry); }
+
+template <typename Geometry1, typename Geometry2, typename Op>
+constexpr auto for_each_leaf(const CSG<Geometry1, Geometry2, Op> &csg, auto &&function) {
+    for_each_leaf(csg.geometry_1(), function);
+    for_each_leaf(csg.geometry_2(), function);
+}
+
 template <typename Geometry1, typename Geometry2>
 constexpr auto construct_union(Geometry1 &&geometry_1, Geometry2 &&geometry_2) {
     return Union<Geometry1, Geometry2>(std::forward<Geometry1>(geometry_1), std::forward<Geometry2>(geometry_2));
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <tuple>
+#include <vector>
+
+#include "bounds.hpp"
+#include "hit.hpp"
+#include "parallel.hpp"
+#include "tensor.hpp"
+
+namespace coex::geometry {
+
+// Signed distance field of an object sampled over a box into a sparse two-level grid (a brick map), so that sphere
+// tracing can take its steps through empty space without evaluating the object. A coarse cell away from every surface
+// keeps a single bound; the others point to a brick of finer samples. Since a distance field is 1-Lipschitz, the
+// distance at the center of a cell minus half its diagonal bounds the distance anywhere in the cell from below. Only
+// bounds of at least one cell are kept, so that every step through the grid advances by at least one fine cell.
+template <typename Scalar>
+class DistanceCache {
+   public:
+    // number of fine cells along each axis of a brick
+    static constexpr std::size_t brick_size = 8;
+
+    static constexpr auto npos = std::numeric_limits<std::uint32_t>::max();
+
+    constexpr DistanceCache() = default;
+
+    // `resolution` is the number of fine cells along the longest axis of the box.
+    constexpr DistanceCache(const auto &object, const AABB<Scalar> &bounds, std::size_t resolution)
+        : m_bounds(bounds) {
+        auto num_cells = std::max<std::size_t>(resolution / brick_size, 1);
+        auto extent = std::max({bounds.extent(0), bounds.extent(1), bounds.extent(2)});
+        auto cell_size = extent / num_cells;
+        m_fine_size = cell_size / brick_size;
+        for (auto axis = 0; axis < 3; ++axis) {
+            m_num_cells[axis] = std::max<std::size_t>(static_cast<std::size_t>(bounds.extent(axis) / cell_size), 1);
+            // cover the whole box with whole cells
+            while (m_num_cells[axis] * cell_size < bounds.extent(axis)) ++m_num_cells[axis];
+        }
+
+        auto half_diagonal = [](auto size) { return std::numbers::sqrt3_v<Scalar> / 2 * size; };
+        auto center = [&](auto coord_x, auto coord_y, auto coord_z, auto size) {
+            return coex::tensor::Vector<Scalar, 3>{bounds.lower[0] + (coord_x + Scalar(0.5)) * size,
+                                                   bounds.lower[1] + (coord_y + Scalar(0.5)) * size,
+                                                   bounds.lower[2] + (coord_z + Scalar(0.5)) * size};
+        };
+
+        // Coarse cells away from every surface keep their bound, and so do cells deep inside a surface, which sphere
+        // tracing never steps through. All the others get a brick.
+        std::vector<std::tuple<std::array<std::size_t, 3>, Scalar>> brick_cells;
+        m_cell_bounds.resize(m_num_cells[0] * m_num_cells[1] * m_num_cells[2]);
+        m_bricks.resize(m_cell_bounds.size(), npos);
+        for (std::size_t coord_z = 0; coord_z < m_num_cells[2]; ++coord_z) {
+            for (std::size_t coord_y = 0; coord_y < m_num_cells[1]; ++coord_y) {
+                for (std::size_t coord_x = 0; coord_x < m_num_cells[0]; ++coord_x) {
+                    auto cell = (coord_z * m_num_cells[1] + coord_y) * m_num_cells[0] + coord_x;
+                    auto distance = object.distance(center(coord_x, coord_y, coord_z, cell_size)).distance;
+                    if (distance - half_diagonal(cell_size) >= cell_size ||
+                        distance + half_diagonal(cell_size) <= -cell_size) {
+                        m_cell_bounds[cell] = std::max(distance - half_diagonal(cell_size), Scalar(0));
+                    } else {
+                        m_bricks[cell] = static_cast<std::uint32_t>(brick_cells.size());
+                        brick_cells.emplace_back(std::array<std::size_t, 3>{coord_x, coord_y, coord_z}, distance);
+                    }
+                }
+            }
+        }
+
+        // Samples that the distance at the center of their cell already keeps from a bound of one fine cell are not
+        // evaluated at all.
+        m_samples.resize(brick_cells.size() * brick_size * brick_size * brick_size);
+        auto fill = [&](std::size_t brick) {
+            const auto &[coords, cell_distance] = brick_cells[brick];
+            auto cell_center = center(coords[0], coords[1], coords[2], cell_size);
+            auto sample = brick * brick_size * brick_size * brick_size;
+            for (std::size_t fine_z = 0; fine_z < brick_size; ++fine_z) {
+                for (std::size_t fine_y = 0; fine_y < brick_size; ++fine_y) {
+                    for (std::size_t fine_x = 0; fine_x < brick_size; ++fine_x) {
+                        auto position = center(coords[0] * brick_size + fine_x, coords[1] * brick_size + fine_y,
+                                               coords[2] * brick_size + fine_z, m_fine_size);
+                        auto bound = Scalar(0);
+                        if (cell_distance + coex::tensor::norm(position - cell_center) >=
+                            m_fine_size + half_diagonal(m_fine_size)) {
+                            auto distance = object.distance(position).distance - half_diagonal(m_fine_size);
+                            if (distance >= m_fine_size) bound = distance;
+                        }
+                        m_samples[sample++] = bound;
+                    }
+                }
+            }
+        };
+#if IS_CONSTANT_EVALUATED
+        for (std::size_t brick = 0; brick < brick_cells.size(); ++brick) fill(brick);
+#else
+        coex::parallel::ThreadPool().run(brick_cells.size(), [&](auto brick, auto) { fill(brick); });
+#endif
+    }
+
+    constexpr const auto &bounds() const { return m_bounds; }
+
+    constexpr auto num_bricks() const { return m_samples.size() / (brick_size * brick_size * brick_size); }
+
+    // Lower bound of the distance from a point outside every surface to the nearest one, or zero where the cache
+    // cannot tell: near or inside a surface, and outside the box.
+    constexpr auto lower_bound(const auto &position) const -> Scalar {
+        std::array<std::size_t, 3> coords;
+        for (auto axis = 0; axis < 3; ++axis) {
+            auto offset = (position[axis] - m_bounds.lower[axis]) / m_fine_size;
+            if (!(offset >= 0 && offset < m_num_cells[axis] * brick_size)) return 0;
+            coords[axis] = static_cast<std::size_t>(offset);
+        }
+
+        auto cell = (coords[2] / brick_size * m_num_cells[1] + coords[1] / brick_size) * m_num_cells[0] +
+                    coords[0] / brick_size;
+        auto brick = m_bricks[cell];
+        if (brick == npos) return m_cell_bounds[cell];
+
+        auto sample = ((coords[2] % brick_size) * brick_size + coords[1] % brick_size) * brick_size +
+                      coords[0] % brick_size;
+        return m_samples[brick * brick_size * brick_size * brick_size + sample];
+    }
+
+   private:
+    AABB<Scalar> m_bounds;
+    Scalar m_fine_size = 0;
+    std::array<std::size_t, 3> m_num_cells{};
+    // bound of each coarse cell without a brick
+    std::vector<Scalar> m_cell_bounds;
+    // brick of each coarse cell, or `npos`
+    std::vector<std::uint32_t> m_bricks;
+    // bounds of the fine cells, brick by brick
+    std::vector<Scalar> m_samples;
+};
+
+// An object whose distance queries are answered from a cache of its distance field wherever the cache can tell, and
+// by the object itself near its surfaces, so that surfaces are found exactly as without the cache. Away from surfaces,
+// the hit record only carries the bound, with no primitive.
+template <typename Scalar, typename Object>
+class CachedObject {
+   public:
+    constexpr CachedObject(const DistanceCache<Scalar> &cache, const Object &object)
+        : m_cache(&cache), m_object(&object) {}
+
+    constexpr auto distance(const auto &position) const {
+        auto bound = m_cache->lower_bound(position);
+        if (bound > 0) return Hit<Scalar>{bound};
+        return m_object->distance(position);
+    }
+
+    constexpr auto normal(std::uint32_t primitive, const auto &position) const {
+        return m_object->normal(primitive, position);
+    }
+
+   private:
+    const DistanceCache<Scalar> *m_cache;
+    const Object *m_object;
+};
+
+template <typename Scalar, typename Object>
+constexpr auto cached(const DistanceCache<Scalar> &cache, const Object &object) {
+    return CachedObject<Scalar, Object>(cache, object);
+}
+
+}  // namespace coex::geometry
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace coex::geometry {
+
+// Compact record of the nearest surface found by a query: the distance to it, the index of its primitive and the ID
+// of its material in the material table of the scene. A ray that hits nothing gets the default record, at infinity.
+// In a CSG tree, primitives are numbered by leaf from left to right, and the material ID of a leaf is its index.
+template <typename Scalar>
+struct Hit {
+    static constexpr auto npos = std::numeric_limits<std::uint32_t>::max();
+
+    Scalar distance = std::numeric_limits<Scalar>::infinity();
+    std::uint32_t primitive = npos;
+    std::uint32_t material = npos;
+
+    constexpr explicit operator bool() const { return primitive != npos; }
+};
+
+// An origin whose squared distance to the center of a sphere is within this many machine epsilons of it from the
+// squared radius lies on the sphere as far as rounding can tell. A ray starting there is taken to leave the surface,
+// so that the intersection at its origin is ignored and it does not hit the surface it leaves again.
+template <typename Scalar>
+inline constexpr Scalar sphere_tolerance = 16 * std::numeric_limits<Scalar>::epsilon();
+
+}  // namespace coex::geometry
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "csg.hpp"
+#include "reflection.hpp"
+#include "tensor.hpp"
+
+namespace coex::geometry {
+
+// Materials of the leaves of a CSG tree, indexed by leaf.
+template <typename Scalar, template <typename, auto> typename Vector = coex::tensor::Vector>
+constexpr auto collect_materials(const auto &object) {
+    std::vector<coex::reflection::Material<Scalar, Vector>> materials;
+    for_each_leaf(object, [&](const auto &leaf) { materials.emplace_back(leaf.material()); });
+    return coex::reflection::MaterialTable<Scalar, Vector>(std::move(materials));
+}
+
+// Build the material table of a constant object at compile time, e.g. `inline constexpr auto materials =
+// construct_material_table<object, Scalar>();`.
+template <const auto &Object, typename Scalar, template <typename, auto> typename Vector = coex::tensor::Vector>
+constexpr auto construct_material_table() {
+    constexpr auto num_materials = num_leaves_v<std::decay_t<decltype(Object)>>;
+    return coex::reflection::MaterialTable<Scalar, Vector, num_materials>(collect_materials<Scalar, Vector>(Object));
+}
+
+}  // namespace coex::geometry
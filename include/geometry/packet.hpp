@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#include "camera.hpp"
+#include "hit.hpp"
+#include "tensor.hpp"
+
+namespace coex::geometry {
+
+// default packet width: one register of the widest vector extension enabled at build time
+template <typename Scalar>
+inline constexpr std::size_t packet_width =
+#if defined(__AVX512F__)
+    64 / sizeof(Scalar);
+#elif defined(__AVX__)
+    32 / sizeof(Scalar);
+#else
+    4;
+#endif
+
+// Coherent rays in structure-of-arrays layout; lanes outside the mask are inactive.
+template <typename Scalar, std::size_t Width, template <typename, auto> typename Vector = coex::tensor::Vector>
+struct RayPacket {
+    alignas(64) std::array<std::array<Scalar, Width>, 3> positions{};
+    alignas(64) std::array<std::array<Scalar, Width>, 3> directions{};
+    std::uint32_t mask = 0;
+
+    constexpr auto set(std::size_t lane, const auto &ray) {
+        for (auto component = 0; component < 3; ++component) {
+            positions[component][lane] = ray.position()[component];
+            directions[component][lane] = ray.direction()[component];
+        }
+        mask |= std::uint32_t{1} << lane;
+    }
+
+    constexpr auto ray(std::size_t lane) const {
+        return coex::camera::Ray<Scalar, Vector>(
+            Vector<Scalar, 3>{positions[0][lane], positions[1][lane], positions[2][lane]},
+            Vector<Scalar, 3>{directions[0][lane], directions[1][lane], directions[2][lane]});
+    }
+};
+
+// Nearest hits of a packet found so far, as hit records in structure-of-arrays layout. Inactive lanes start at
+// distance zero so that they never take a hit.
+template <typename Scalar, std::size_t Width>
+struct PacketHit {
+    alignas(64) std::array<Scalar, Width> distances;
+    std::array<std::uint32_t, Width> primitives;
+    std::array<std::uint32_t, Width> materials;
+
+    constexpr PacketHit(std::uint32_t mask) {
+        for (std::size_t lane = 0; lane < Width; ++lane) {
+            distances[lane] = mask >> lane & 1 ? std::numeric_limits<Scalar>::infinity() : Scalar(0);
+        }
+        primitives.fill(Hit<Scalar>::npos);
+        materials.fill(Hit<Scalar>::npos);
+    }
+
+    constexpr auto set(std::size_t lane, const Hit<Scalar> &hit) {
+        distances[lane] = hit.distance;
+        primitives[lane] = hit.primitive;
+        materials[lane] = hit.material;
+    }
+
+    constexpr auto hit(std::size_t lane) const {
+        if (!(distances[lane] < std::numeric_limits<Scalar>::infinity())) return Hit<Scalar>{};
+        return Hit<Scalar>{distances[lane], primitives[lane], materials[lane]};
+    }
+};
+
+// Intersect every lane of a packet with one sphere, the same way Sphere::intersect does, and keep the nearer hits.
+// Returns the mask of the lanes whose hit got nearer.
+template <typename Scalar, std::size_t Width>
+inline auto intersect_sphere(const auto &position, Scalar radius, const RayPacket<Scalar, Width> &packet,
+                             std::array<Scalar, Width> &distances) -> std::uint32_t {
+#if defined(__AVX512F__)
+    if constexpr (std::is_same_v<Scalar, double> && Width == 8) {
+        auto dot = [](auto x0, auto y0, auto x1, auto y1, auto x2, auto y2) {
+            return _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(x0, y0), _mm512_mul_pd(x1, y1)), _mm512_mul_pd(x2, y2));
+        };
+        auto dx = _mm512_loadu_pd(packet.directions[0].data());
+        auto dy = _mm512_loadu_pd(packet.directions[1].data());
+        auto dz = _mm512_loadu_pd(packet.directions[2].data());
+        auto ox = _mm512_sub_pd(_mm512_loadu_pd(packet.positions[0].data()), _mm512_set1_pd(position[0]));
+        auto oy = _mm512_sub_pd(_mm512_loadu_pd(packet.positions[1].data()), _mm512_set1_pd(position[1]));
+        auto oz = _mm512_sub_pd(_mm512_loadu_pd(packet.positions[2].data()), _mm512_set1_pd(position[2]));
+        auto zero = _mm512_setzero_pd();
+        auto minus_one = _mm512_set1_pd(-1.0);
+        auto squared_radius = _mm512_set1_pd(radius * radius);
+        // The unmasked sqrt, min and max pass an undefined vector through, which GCC warns about, so they are used in
+        // their zero-masked forms over all the lanes instead.
+        constexpr __mmask8 lanes = 0xff;
+        auto a = dot(dx, dx, dy, dy, dz, dz);
+        auto b = dot(dx, ox, dy, oy, dz, oz);
+        auto squared_norm = dot(ox, ox, oy, oy, oz, oz);
+        auto c = _mm512_sub_pd(squared_norm, squared_radius);
+        auto k = _mm512_div_pd(b, a);
+        auto lx = _mm512_sub_pd(ox, _mm512_mul_pd(k, dx));
+        auto ly = _mm512_sub_pd(oy, _mm512_mul_pd(k, dy));
+        auto lz = _mm512_sub_pd(oz, _mm512_mul_pd(k, dz));
+        auto d = _mm512_mul_pd(a, _mm512_sub_pd(squared_radius, dot(lx, lx, ly, ly, lz, lz)));
+        auto root = _mm512_maskz_sqrt_pd(lanes, _mm512_maskz_max_pd(lanes, d, zero));
+        root = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(b, zero, _CMP_LT_OQ), root, _mm512_mul_pd(root, minus_one));
+        auto q = _mm512_mul_pd(_mm512_add_pd(b, root), minus_one);
+        auto leaving =
+            _mm512_cmp_pd_mask(_mm512_abs_pd(c), _mm512_mul_pd(_mm512_set1_pd(sphere_tolerance<Scalar>), squared_norm),
+                               _CMP_LE_OQ);
+        auto distance_1 = _mm512_mask_blend_pd(leaving, _mm512_div_pd(c, q),
+                                               _mm512_set1_pd(-std::numeric_limits<Scalar>::infinity()));
+        auto distance_2 = _mm512_div_pd(q, a);
+        auto near = _mm512_maskz_min_pd(lanes, distance_1, distance_2);
+        auto far = _mm512_maskz_max_pd(lanes, distance_1, distance_2);
+        auto distance = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(near, zero, _CMP_GT_OQ), far, near);
+        auto nearest = _mm512_loadu_pd(distances.data());
+        auto mask = _mm512_cmp_pd_mask(d, zero, _CMP_GE_OQ) & _mm512_cmp_pd_mask(distance, zero, _CMP_GT_OQ) &
+                    _mm512_cmp_pd_mask(distance, nearest, _CMP_LT_OQ);
+        _mm512_storeu_pd(distances.data(), _mm512_mask_blend_pd(mask, nearest, distance));
+        return mask;
+    }
+#endif
+#if defined(__AVX__)
+    if constexpr (std::is_same_v<Scalar, double> && Width == 4) {
+        auto dot = [](auto x0, auto y0, auto x1, auto y1, auto x2, auto y2) {
+            return _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(x0, y0), _mm256_mul_pd(x1, y1)), _mm256_mul_pd(x2, y2));
+        };
+        auto dx = _mm256_loadu_pd(packet.directions[0].data());
+        auto dy = _mm256_loadu_pd(packet.directions[1].data());
+        auto dz = _mm256_loadu_pd(packet.directions[2].data());
+        auto ox = _mm256_sub_pd(_mm256_loadu_pd(packet.positions[0].data()), _mm256_set1_pd(position[0]));
+        auto oy = _mm256_sub_pd(_mm256_loadu_pd(packet.positions[1].data()), _mm256_set1_pd(position[1]));
+        auto oz = _mm256_sub_pd(_mm256_loadu_pd(packet.positions[2].data()), _mm256_set1_pd(position[2]));
+        auto zero = _mm256_setzero_pd();
+        auto minus_one = _mm256_set1_pd(-1.0);
+        auto squared_radius = _mm256_set1_pd(radius * radius);
+        auto a = dot(dx, dx, dy, dy, dz, dz);
+        auto b = dot(dx, ox, dy, oy, dz, oz);
+        auto squared_norm = dot(ox, ox, oy, oy, oz, oz);
+        auto c = _mm256_sub_pd(squared_norm, squared_radius);
+        auto k = _mm256_div_pd(b, a);
+        auto lx = _mm256_sub_pd(ox, _mm256_mul_pd(k, dx));
+        auto ly = _mm256_sub_pd(oy, _mm256_mul_pd(k, dy));
+        auto lz = _mm256_sub_pd(oz, _mm256_mul_pd(k, dz));
+        auto d = _mm256_mul_pd(a, _mm256_sub_pd(squared_radius, dot(lx, lx, ly, ly, lz, lz)));
+        auto root = _mm256_sqrt_pd(_mm256_max_pd(d, zero));
+        root = _mm256_blendv_pd(root, _mm256_mul_pd(root, minus_one), _mm256_cmp_pd(b, zero, _CMP_LT_OQ));
+        auto q = _mm256_mul_pd(_mm256_add_pd(b, root), minus_one);
+        // the absolute value of c, with its sign bit cleared
+        auto leaving = _mm256_cmp_pd(_mm256_andnot_pd(_mm256_set1_pd(-0.0), c),
+                                     _mm256_mul_pd(_mm256_set1_pd(sphere_tolerance<Scalar>), squared_norm), _CMP_LE_OQ);
+        auto distance_1 =
+            _mm256_blendv_pd(_mm256_div_pd(c, q), _mm256_set1_pd(-std::numeric_limits<Scalar>::infinity()), leaving);
+        auto distance_2 = _mm256_div_pd(q, a);
+        auto near = _mm256_min_pd(distance_1, distance_2);
+        auto far = _mm256_max_pd(distance_1, distance_2);
+        auto distance = _mm256_blendv_pd(far, near, _mm256_cmp_pd(near, zero, _CMP_GT_OQ));
+        auto nearest = _mm256_loadu_pd(distances.data());
+        auto mask = _mm256_and_pd(
+            _mm256_and_pd(_mm256_cmp_pd(d, zero, _CMP_GE_OQ), _mm256_cmp_pd(distance, zero, _CMP_GT_OQ)),
+            _mm256_cmp_pd(distance, nearest, _CMP_LT_OQ));
+        _mm256_storeu_pd(distances.data(), _mm256_blendv_pd(nearest, distance, mask));
+        return static_cast<std::uint32_t>(_mm256_movemask_pd(mask));
+    }
+#endif
+    // portable fallback, laid out lane by lane for the auto-vectorizer
+    std::uint32_t mask = 0;
+    for (std::size_t lane = 0; lane < Width; ++lane) {
+        auto dx = packet.directions[0][lane], dy = packet.directions[1][lane], dz = packet.directions[2][lane];
+        auto ox = packet.positions[0][lane] - position[0];
+        auto oy = packet.positions[1][lane] - position[1];
+        auto oz = packet.positions[2][lane] - position[2];
+        auto a = dx * dx + dy * dy + dz * dz;
+        auto b = dx * ox + dy * oy + dz * oz;
+        auto squared_norm = ox * ox + oy * oy + oz * oz;
+        auto c = squared_norm - radius * radius;
+        auto k = b / a;
+        auto lx = ox - k * dx, ly = oy - k * dy, lz = oz - k * dz;
+        auto d = a * (radius * radius - (lx * lx + ly * ly + lz * lz));
+        auto root = std::sqrt(std::max(d, Scalar(0)));
+        auto q = -(b + (b < 0 ? -root : root));
+        auto distance_1 = std::abs(c) <= sphere_tolerance<Scalar> * squared_norm
+                              ? -std::numeric_limits<Scalar>::infinity()
+                              : c / q;
+        auto distance_2 = q / a;
+        auto near = distance_1 < distance_2 ? distance_1 : distance_2;
+        auto far = distance_1 > distance_2 ? distance_1 : distance_2;
+        auto distance = near > 0 ? near : far;
+        auto hit = d >= 0 && distance > 0 && distance < distances[lane];
+        distances[lane] = hit ? distance : distances[lane];
+        mask |= std::uint32_t{hit} << lane;
+    }
+    return mask;
+}
+
+}  // namespace coex::geometry
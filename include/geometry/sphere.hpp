@@ -1,10 +1,17 @@
 #pragma once
 
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <optional>
 #include <variant>
 
+#include "bounds.hpp"
 #include "geometry.hpp"
+#include "hit.hpp"
 #include "math.hpp"
+#include "packet.hpp"
 #include "reflection.hpp"
 #include "tensor.hpp"
 
@@ -31,35 +38,67 @@ class Sphere {
     constexpr auto &material() { return m_material; }
     constexpr const auto &material() const { return m_material; }
 
-    constexpr auto intersect(const auto &ray) const {
+    // As a leaf, the sphere is primitive `index` with material `index`.
+    constexpr auto intersect(const auto &ray, std::uint32_t index = 0) const {
+        auto distance = intersect_distance(ray);
+        return distance ? Hit<Scalar>{distance.value(), index, index} : Hit<Scalar>{};
+    }
+
+    // Distance along the ray to the nearest intersection in front of its origin, if any. The discriminant is taken from
+    // the point of the ray closest to the center rather than as b^2 - ac, and the roots as c / q and q / a, which keeps
+    // both from cancelling catastrophically in float (see Ray Tracing Gems, chapter 7). The root at the origin of a ray
+    // leaving the surface is ignored (see sphere_tolerance).
+    constexpr auto intersect_distance(const auto &ray) const -> std::optional<Scalar> {
         auto direction = ray.position() - m_position;
         auto a = coex::tensor::dot(ray.direction(), ray.direction());
         auto b = coex::tensor::dot(ray.direction(), direction);
-        auto c = coex::tensor::dot(direction, direction) - m_radius * m_radius;
-        auto d = b * b - a * c;
+        auto squared_norm = coex::tensor::dot(direction, direction);
+        auto c = squared_norm - m_radius * m_radius;
+        auto offset = direction - b / a * ray.direction();
+        auto d = a * (m_radius * m_radius - coex::tensor::dot(offset, offset));
 
         if (d >= 0) {
-            auto distance_1 = (-b - coex::math::sqrt(d)) / a;
-            auto distance_2 = (-b + coex::math::sqrt(d)) / a;
-            if (distance_1 > 0.0 || distance_2 > 0.0) {
-                auto distance =
-                    distance_1 > 0.0 ? distance_2 > 0.0 ? std::min(distance_1, distance_2) : distance_1 : distance_2;
-                return std::make_tuple(Geometry<Scalar, Vector>(*this), std::optional<Scalar>(distance));
-            } else {
-                return std::make_tuple(Geometry<Scalar, Vector>(*this), std::optional<Scalar>{});
-            }
-        } else {
-            return std::make_tuple(Geometry<Scalar, Vector>(*this), std::optional<Scalar>{});
+            auto root = coex::math::sqrt(d);
+            auto q = -(b + (b < 0 ? -root : root));
+            auto distance_1 = std::abs(c) <= sphere_tolerance<Scalar> * squared_norm
+                                  ? -std::numeric_limits<Scalar>::infinity()
+                                  : c / q;
+            auto distance_2 = q / a;
+            auto near = distance_1 < distance_2 ? distance_1 : distance_2;
+            auto far = distance_1 > distance_2 ? distance_1 : distance_2;
+            auto distance = near > 0 ? near : far;
+            if (distance > 0) return distance;
+        }
+        return {};
+    }
+
+    // Intersect a packet of rays at once, keeping the nearer hits.
+    template <std::size_t Width>
+    auto intersect(const RayPacket<Scalar, Width, Vector> &packet, auto &hit, std::uint32_t index = 0) const {
+        for (auto mask = intersect_sphere(m_position, m_radius, packet, hit.distances); mask; mask &= mask - 1) {
+            hit.primitives[std::countr_zero(mask)] = index;
+            hit.materials[std::countr_zero(mask)] = index;
         }
     }
 
-    constexpr auto distance(const auto &position) const {
+    constexpr auto distance(const auto &position, std::uint32_t index = 0) const {
         auto distance = coex::tensor::norm(position - m_position) - m_radius;
-        return std::make_tuple(Geometry<Scalar, Vector>(*this), distance);
+        return Hit<Scalar>{distance, index, index};
     }
 
     constexpr auto normal(const auto &position) const { return (position - m_position) / m_radius; }
 
+    constexpr auto normal(std::uint32_t, const auto &position) const { return normal(position); }
+
+    constexpr auto bounds() const {
+        AABB<Scalar> bounds;
+        for (auto axis = 0; axis < 3; ++axis) {
+            bounds.lower[axis] = m_position[axis] - m_radius;
+            bounds.upper[axis] = m_position[axis] + m_radius;
+        }
+        return bounds;
+    }
+
    private:
     Scalar m_radius;
     Vector<Scalar, 3> m_position;
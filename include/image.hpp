@@ -1 +1,5 @@
+#include "image/encoding.hpp"
+#include "image/mapped.hpp"
+#include "image/pfm.hpp"
+#include "image/pgm.hpp"
 #include "image/ppm.hpp"
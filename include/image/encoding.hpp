@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace coex::image {
+
+// Components of contiguous colors as one flat array, so that they can be encoded in bulk whatever the pixel they
+// belong to.
+auto components(const auto &colors) {
+    using Color = std::remove_cvref_t<decltype(*std::data(colors))>;
+    using Scalar = std::remove_cvref_t<decltype(std::declval<Color>()[0])>;
+    constexpr auto num_components = Color().size();
+    static_assert(sizeof(Color) == sizeof(Scalar) * num_components);
+    return std::span<const Scalar>(reinterpret_cast<const Scalar *>(std::data(colors)),
+                                   std::size(colors) * num_components);
+}
+
+// Gamma correction (a square root), clamping to [0, 1] and quantization to unsigned integers of `Sample`, fused into
+// one pass over the components. 16-bit samples are written big-endian, as binary PPM stores them. Values are
+// truncated, as the ASCII writer does, so that every format holds the same image.
+template <typename Sample, typename Scalar>
+    requires std::is_same_v<Sample, std::uint8_t> || std::is_same_v<Sample, std::uint16_t>
+auto quantize(std::span<const Scalar> components, Sample *samples) {
+    constexpr auto max_value = static_cast<Scalar>(static_cast<Sample>(-1));
+    std::size_t index = 0;
+
+#if defined(__AVX__)
+    if constexpr (std::is_same_v<Scalar, double>) {
+        auto zero = _mm256_setzero_pd();
+        auto one = _mm256_set1_pd(1.0);
+        auto scale = _mm256_set1_pd(max_value);
+        // four components to four 32-bit integers
+        auto convert = [&](const auto *components) {
+            auto value = _mm256_sqrt_pd(_mm256_max_pd(_mm256_loadu_pd(components), zero));
+            return _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_min_pd(value, one), scale));
+        };
+        if constexpr (std::is_same_v<Sample, std::uint8_t>) {
+            for (; index + 16 <= components.size(); index += 16) {
+                auto low = _mm_packus_epi32(convert(components.data() + index), convert(components.data() + index + 4));
+                auto high =
+                    _mm_packus_epi32(convert(components.data() + index + 8), convert(components.data() + index + 12));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(samples + index), _mm_packus_epi16(low, high));
+            }
+        } else {
+            auto swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+            for (; index + 8 <= components.size(); index += 8) {
+                auto value =
+                    _mm_packus_epi32(convert(components.data() + index), convert(components.data() + index + 4));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(samples + index), _mm_shuffle_epi8(value, swap));
+            }
+        }
+    }
+#endif
+    // portable loop for the remaining components, simple enough for the auto-vectorizer
+    for (; index < components.size(); ++index) {
+        auto sample = static_cast<Sample>(std::min(std::sqrt(std::max(components[index], Scalar(0))), Scalar(1)) *
+                                          max_value);
+        if constexpr (sizeof(Sample) == 2) sample = static_cast<Sample>(sample << 8 | sample >> 8);
+        samples[index] = sample;
+    }
+}
+
+// Conversion of linear components to 32-bit floats, as PFM stores them.
+template <typename Scalar>
+auto convert(std::span<const Scalar> components, float *samples) {
+    std::transform(std::begin(components), std::end(components), samples,
+                   [](auto component) { return static_cast<float>(component); });
+}
+
+// Write a header and its payload, which goes out in one large write rather than through the stream piece by piece.
+template <typename T>
+auto write_file(const auto &filename, const std::string &header, std::span<const T> payload) {
+    std::ofstream ostream(filename, std::ios::binary);
+    ostream << header;
+    ostream.write(reinterpret_cast<const char *>(payload.data()), payload.size_bytes());
+}
+
+}  // namespace coex::image
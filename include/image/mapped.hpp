@@ -0,0 +1,96 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include "encoding.hpp"
+#include "pfm.hpp"
+#include "ppm.hpp"
+
+namespace coex::image {
+
+// Whole image file, sized up front and mapped into memory, into which patches and tiles encode their rows directly.
+// The file is a binary PPM of 8-bit or 16-bit samples, or a PFM with float samples. Every process mapping the same
+// file writes the same header and its own region, so that patches rendered by separate processes, or tiles rendered
+// by forked workers, are assembled in place without any intermediate file.
+template <typename Sample = std::uint8_t>
+    requires std::is_same_v<Sample, std::uint8_t> || std::is_same_v<Sample, std::uint16_t> ||
+             std::is_same_v<Sample, float>
+class MappedImage {
+   public:
+    static constexpr auto pfm = std::is_same_v<Sample, float>;
+
+    MappedImage(const std::string &filename, std::size_t width, std::size_t height)
+        : m_width(width), m_height(height) {
+        auto header = [&] {
+            if constexpr (pfm) {
+                return pfm_header(width, height);
+            } else {
+                return binary_ppm_header<Sample>(width, height);
+            }
+        }();
+        m_size = header.size() + sizeof(Sample) * 3 * width * height;
+
+        auto descriptor = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+        if (descriptor < 0) throw std::system_error(errno, std::generic_category(), filename);
+        // resizing to the same size keeps what other processes have written already
+        if (::ftruncate(descriptor, m_size) < 0) {
+            auto error = errno;
+            ::close(descriptor);
+            throw std::system_error(error, std::generic_category(), filename);
+        }
+        auto address = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+        auto error = errno;
+        ::close(descriptor);
+        if (address == MAP_FAILED) throw std::system_error(error, std::generic_category(), filename);
+
+        m_data = static_cast<char *>(address);
+        std::memcpy(m_data, header.data(), header.size());
+        m_samples = reinterpret_cast<Sample *>(m_data + header.size());
+    }
+
+    MappedImage(const MappedImage &) = delete;
+    MappedImage &operator=(const MappedImage &) = delete;
+
+    ~MappedImage() { ::munmap(m_data, m_size); }
+
+    auto width() const { return m_width; }
+    auto height() const { return m_height; }
+
+    // Encode the linear radiance of a region, given row by row, into its place in the file: gamma-corrected and
+    // quantized for PPM, as is for PFM, whose rows go from bottom to top.
+    auto write(const auto &region, const auto &colors) {
+        auto components = coex::image::components(colors);
+        auto row_size = 3 * region.width;
+        for (std::size_t coord_y = 0; coord_y < region.height; ++coord_y) {
+            auto row = components.subspan(row_size * coord_y, row_size);
+            auto image_y = region.y + coord_y;
+            if constexpr (pfm) image_y = m_height - 1 - image_y;
+            auto samples = m_samples + 3 * (m_width * image_y + region.x);
+            if constexpr (pfm) {
+                convert(row, samples);
+            } else {
+                quantize(row, samples);
+            }
+        }
+    }
+
+   private:
+    std::size_t m_width;
+    std::size_t m_height;
+    std::size_t m_size;
+    char *m_data;
+    Sample *m_samples;
+};
+
+}  // namespace coex::image
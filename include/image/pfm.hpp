@@ -0,0 +1,34 @@
+#pragma once
+
+#include <bit>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "encoding.hpp"
+
+namespace coex::image {
+
+// Header of a PFM of the native byte order, told by the sign of its scale, which is padded with zeros so that the
+// samples after it are aligned.
+auto pfm_header(auto width, auto height) {
+    auto header = std::string("PF\n") + std::to_string(width) + " " + std::to_string(height) + "\n" +
+                  (std::endian::native == std::endian::little ? "-1." : "1.");
+    header.append(sizeof(float) - (header.size() + 1) % sizeof(float), '0');
+    return header + "\n";
+}
+
+// Write linear radiance as a PFM of 32-bit floats without gamma correction, to keep the full range for compositing.
+// PFM stores rows from bottom to top.
+auto write_pfm(const auto &filename, const auto &colors, auto width, auto height) {
+    auto components = coex::image::components(colors);
+    auto row_size = components.size() / height;
+    std::vector<float> samples(components.size());
+    for (auto y = decltype(height){}; y < height; ++y) {
+        convert(components.subspan(row_size * y, row_size), samples.data() + row_size * (height - 1 - y));
+    }
+
+    write_file(filename, pfm_header(width, height), std::span<const float>(samples));
+}
+
+}  // namespace coex::image
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+
+namespace coex::image {
+
+// Write integer values (e.g. per-pixel sample counts), given row by row, as a greyscale image, keeping their full
+// range.
+auto write_pgm(const auto &filename, const auto &values, auto width, auto height) {
+    std::ofstream ostream(filename);
+
+    auto max_value = std::max<std::uintmax_t>(*std::max_element(std::begin(values), std::end(values)), 1);
+
+    ostream << "P2\n";
+    ostream << width << " " << height << "\n";
+    ostream << std::min<std::uintmax_t>(max_value, (1 << 16) - 1) << "\n";
+
+    auto value = std::begin(values);
+    for (auto y = decltype(height){}; y < height; ++y) {
+        for (auto x = decltype(width){}; x < width; ++x) {
+            ostream << std::min<std::uintmax_t>(*value++, (1 << 16) - 1) << " ";
+        }
+        ostream << "\n";
+    }
+}
+
+}  // namespace coex::image
@@ -2,6 +2,11 @@
 
 #include <cstdint>
 #include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "encoding.hpp"
 
 namespace coex::image {
 
@@ -20,4 +25,24 @@ auto write_ppm(const auto &filename, const auto &colors, auto width, auto height
     }
 }
 
+// Header of a binary PPM of 8-bit or 16-bit samples, padded with whitespace before the maximum value so that the
+// samples after it are aligned.
+template <typename Sample = std::uint8_t>
+auto binary_ppm_header(auto width, auto height) {
+    auto header = std::string("P6\n") + std::to_string(width) + " " + std::to_string(height) + "\n";
+    auto max_value = std::to_string(static_cast<Sample>(-1)) + "\n";
+    header.append((sizeof(Sample) - (header.size() + max_value.size()) % sizeof(Sample)) % sizeof(Sample), ' ');
+    return header + max_value;
+}
+
+// Write linear radiance as a binary PPM of 8-bit or 16-bit samples, gamma-corrected on the way.
+template <typename Sample = std::uint8_t>
+auto write_binary_ppm(const auto &filename, const auto &colors, auto width, auto height) {
+    auto components = coex::image::components(colors);
+    std::vector<Sample> samples(components.size());
+    quantize(components, samples.data());
+
+    write_file(filename, binary_ppm_header<Sample>(width, height), std::span<const Sample>(samples));
+}
+
 }  // namespace coex::image
@@ -1,11 +1,22 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <complex>
 #include <concepts>
+#include <limits>
 #include <type_traits>
+#include <utility>
 
 namespace coex::math {
 
+// exponentiation by squaring, which needs no identity element and so also serves tensors
+constexpr auto pow(auto x, std::integral auto n) -> decltype(x) {
+    if (n == 1) return x;
+    auto half = pow(x, n / 2);
+    return n % 2 ? half * half * x : half * half;
+}
+
 constexpr auto root_impl(std::floating_point auto x, std::floating_point auto y, std::floating_point auto z,
                          std::integral auto n) -> decltype(x) {
     return z - y < std::numeric_limits<decltype(x)>::epsilon()
@@ -17,20 +28,80 @@ constexpr auto root_impl(std::floating_point auto x, std::floating_point auto y,
     return root_impl(x, y - (pow(y, n) - x) / (n * pow(y, n - 1)), y, n);
 }
 
+// newton's method, for constant evaluation
 constexpr auto root(std::floating_point auto x, std::integral auto n) {
     return root_impl(x, std::max<decltype(x)>(x, 1), n);
 }
 
-constexpr auto sqrt(std::floating_point auto x) { return root(x, 2); }
-
-constexpr auto cbrt(std::floating_point auto x) { return root(x, 3); }
+// the hardware square root at run time, and newton's method at compile time
+constexpr auto sqrt(std::floating_point auto x) {
+    if (std::is_constant_evaluated()) return root(x, 2);
+    return std::sqrt(x);
+}
 
-constexpr auto pow(auto x, std::integral auto n) -> decltype(x) { return n == 1 ? x : x * pow(x, n - 1); }
+constexpr auto cbrt(std::floating_point auto x) {
+    if (std::is_constant_evaluated()) return root(x, 3);
+    return std::cbrt(x);
+}
 
 constexpr auto square(auto x) { return pow(x, 2); }
 
 constexpr auto cube(auto x) { return pow(x, 3); }
 
+// reduces x to x - k pi / 2 in [-pi / 4, pi / 4] in two parts (cody and waite),
+// which is exact for the first 33 bits of pi / 2 and so only accurate up to |x| of about 1e9
+constexpr auto reduce_impl(std::floating_point auto x) {
+    constexpr auto pi_2_head = 1.57079632673412561417e+00;
+    constexpr auto pi_2_tail = 6.07710050650619224932e-11;
+    auto k = static_cast<long long>(x / (pi_2_head + pi_2_tail) + (x < 0 ? -0.5 : 0.5));
+    return std::pair{(x - k * pi_2_head) - k * pi_2_tail, static_cast<int>((k % 4 + 4) % 4)};
+}
+
+// taylor series in nested form, which converges to double precision by the 18th order over [-pi / 4, pi / 4]
+constexpr auto sin_impl(std::floating_point auto r) {
+    auto series = decltype(r)(1);
+    for (auto k = 9; k > 0; --k) series = 1 - r * r / ((2 * k) * (2 * k + 1)) * series;
+    return r * series;
+}
+
+constexpr auto cos_impl(std::floating_point auto r) {
+    auto series = decltype(r)(1);
+    for (auto k = 9; k > 0; --k) series = 1 - r * r / ((2 * k - 1) * (2 * k)) * series;
+    return series;
+}
+
+// the standard library at run time, and argument reduction with taylor series at compile time
+constexpr auto sin(std::floating_point auto x) -> decltype(x) {
+    if (!std::is_constant_evaluated()) return std::sin(x);
+    if (x - x != 0) return std::numeric_limits<decltype(x)>::quiet_NaN();
+    auto [r, quadrant] = reduce_impl(static_cast<std::common_type_t<decltype(x), double>>(x));
+    switch (quadrant) {
+        case 0: return sin_impl(r);
+        case 1: return cos_impl(r);
+        case 2: return -sin_impl(r);
+        default: return -cos_impl(r);
+    }
+}
+
+constexpr auto cos(std::floating_point auto x) -> decltype(x) {
+    if (!std::is_constant_evaluated()) return std::cos(x);
+    if (x - x != 0) return std::numeric_limits<decltype(x)>::quiet_NaN();
+    auto [r, quadrant] = reduce_impl(static_cast<std::common_type_t<decltype(x), double>>(x));
+    switch (quadrant) {
+        case 0: return cos_impl(r);
+        case 1: return -sin_impl(r);
+        case 2: return -cos_impl(r);
+        default: return sin_impl(r);
+    }
+}
+
+constexpr auto tan(std::floating_point auto x) -> decltype(x) {
+    if (!std::is_constant_evaluated()) return std::tan(x);
+    if (x - x != 0) return std::numeric_limits<decltype(x)>::quiet_NaN();
+    auto [r, quadrant] = reduce_impl(static_cast<std::common_type_t<decltype(x), double>>(x));
+    return quadrant % 2 ? -cos_impl(r) / sin_impl(r) : sin_impl(r) / cos_impl(r);
+}
+
 constexpr auto lerp(const auto &in_val, const auto &in_min, const auto &in_max, const auto &out_min,
                     const auto &out_max) {
     return out_min + (out_max - out_min) * (in_val - in_min) / (in_max - in_min);
@@ -0,0 +1,4 @@
+#include "parallel/process_pool.hpp"
+#include "parallel/shared_memory.hpp"
+#include "parallel/thread_pool.hpp"
+#include "parallel/tiling.hpp"
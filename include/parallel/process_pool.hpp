@@ -0,0 +1,130 @@
+#pragma once
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <optional>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "shared_memory.hpp"
+#include "thread_pool.hpp"
+
+namespace coex::parallel {
+
+// Pool of forked worker processes that runs a fixed batch of tasks to completion.
+// Tasks are claimed through a queue in shared memory, so results have to be written to shared memory as well
+// (see SharedArray). When a worker dies, the task it was holding is reissued to a replacement worker.
+class ProcessPool {
+   public:
+    ProcessPool() : ProcessPool(ThreadPool::default_concurrency()) {}
+
+    ProcessPool(std::size_t num_workers, std::size_t max_retries = 3)
+        : m_num_workers(std::max<std::size_t>(num_workers, 1)), m_max_retries(max_retries) {}
+
+    auto num_workers() const { return m_num_workers; }
+
+    auto max_retries() const { return m_max_retries; }
+
+    // Invoke `function(task_index)` for every task index in [0, num_tasks) in the workers, and
+    // `progress(num_done_tasks)` in the calling process as tasks complete.
+    // Returns false if a task kept crashing its worker more than `max_retries` times.
+    auto run(std::size_t num_tasks, auto &&function, auto &&progress) const {
+        static_assert(std::atomic<pid_t>::is_always_lock_free);
+
+        // each task is pending, owned by the worker with the stored pid, or done
+        constexpr pid_t pending = 0;
+        constexpr pid_t done = -1;
+        SharedArray<std::atomic<pid_t>> states(num_tasks);
+        SharedArray<std::atomic<std::size_t>> cursor(1);
+
+        auto work = [&]() {
+            auto pid = ::getpid();
+            auto claim = [&](std::size_t task_index) {
+                auto state = pending;
+                return states[task_index].compare_exchange_strong(state, pid);
+            };
+            auto next = [&]() -> std::optional<std::size_t> {
+                for (auto task_index = cursor[0]++; task_index < num_tasks; task_index = cursor[0]++) {
+                    if (claim(task_index)) return task_index;
+                }
+                // pick up tasks reissued after a crash
+                for (std::size_t task_index = 0; task_index < num_tasks; ++task_index) {
+                    if (claim(task_index)) return task_index;
+                }
+                return std::nullopt;
+            };
+            while (auto task_index = next()) {
+                function(task_index.value());
+                states[task_index.value()] = done;
+            }
+        };
+
+        std::set<pid_t> workers;
+        auto spawn = [&]() {
+            auto pid = ::fork();
+            if (pid == 0) {
+                work();
+                // skip the destructors and exit handlers inherited from the parent
+                std::_Exit(EXIT_SUCCESS);
+            }
+            if (pid > 0) workers.insert(pid);
+            return pid > 0;
+        };
+        auto count = [&](pid_t state) {
+            return std::count_if(states.begin(), states.end(), [&](const auto &other) { return other == state; });
+        };
+        auto kill_workers = [&]() {
+            for (auto pid : workers) ::kill(pid, SIGKILL);
+            for (auto pid : workers) ::waitpid(pid, nullptr, 0);
+            return false;
+        };
+
+        for (std::size_t worker_index = 0; worker_index < std::min(m_num_workers, num_tasks); ++worker_index) {
+            if (!spawn()) return kill_workers();
+        }
+
+        std::vector<std::size_t> num_retries(num_tasks);
+        while (!workers.empty()) {
+            int status;
+            auto pid = ::waitpid(-1, &status, WNOHANG);
+            if (pid == 0) {
+                progress(count(done));
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            if (pid < 0) break;
+
+            workers.erase(pid);
+            if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS) continue;
+
+            // the worker crashed, so reissue its task to a replacement
+            for (std::size_t task_index = 0; task_index < num_tasks; ++task_index) {
+                if (states[task_index] != pid) continue;
+                if (++num_retries[task_index] > m_max_retries) return kill_workers();
+                states[task_index] = pending;
+            }
+            if (count(pending) && !spawn()) return kill_workers();
+        }
+
+        progress(count(done));
+        return static_cast<std::size_t>(count(done)) == num_tasks;
+    }
+
+    auto run(std::size_t num_tasks, auto &&function) const {
+        return run(num_tasks, std::forward<decltype(function)>(function), [](auto) {});
+    }
+
+   private:
+    std::size_t m_num_workers;
+    std::size_t m_max_retries;
+};
+
+}  // namespace coex::parallel
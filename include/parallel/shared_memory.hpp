@@ -0,0 +1,77 @@
+#pragma once
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+namespace coex::parallel {
+
+// Fixed-size array in an anonymous shared mapping, visible to every process forked after its construction.
+template <typename T>
+class SharedArray {
+   public:
+    SharedArray(std::size_t size) : m_size(size) {
+        auto address = ::mmap(nullptr, std::max<std::size_t>(sizeof(T) * size, 1), PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (address == MAP_FAILED) throw std::bad_alloc();
+        m_data = static_cast<T *>(address);
+        std::uninitialized_value_construct_n(m_data, m_size);
+    }
+
+    SharedArray(const SharedArray &) = delete;
+    SharedArray &operator=(const SharedArray &) = delete;
+
+    ~SharedArray() {
+        std::destroy_n(m_data, m_size);
+        ::munmap(m_data, std::max<std::size_t>(sizeof(T) * m_size, 1));
+    }
+
+    auto size() const { return m_size; }
+
+    auto data() { return m_data; }
+    auto data() const { return static_cast<const T *>(m_data); }
+
+    auto &operator[](std::size_t index) { return m_data[index]; }
+    const auto &operator[](std::size_t index) const { return m_data[index]; }
+
+    auto begin() { return m_data; }
+    auto begin() const { return static_cast<const T *>(m_data); }
+
+    auto end() { return m_data + m_size; }
+    auto end() const { return static_cast<const T *>(m_data + m_size); }
+
+   private:
+    std::size_t m_size;
+    T *m_data;
+};
+
+// Allocator handing out anonymous shared mappings, so that containers allocated before a fork, such as the frame that
+// forked workers render into, are shared with every child.
+template <typename T>
+struct SharedAllocator {
+    using value_type = T;
+
+    constexpr SharedAllocator() = default;
+
+    template <typename U>
+    constexpr SharedAllocator(const SharedAllocator<U> &) {}
+
+    auto allocate(std::size_t size) {
+        auto address = ::mmap(nullptr, std::max<std::size_t>(sizeof(T) * size, 1), PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (address == MAP_FAILED) throw std::bad_alloc();
+        return static_cast<T *>(address);
+    }
+
+    auto deallocate(T *pointer, std::size_t size) { ::munmap(pointer, std::max<std::size_t>(sizeof(T) * size, 1)); }
+
+    template <typename U>
+    constexpr auto operator==(const SharedAllocator<U> &) const {
+        return true;
+    }
+};
+
+}  // namespace coex::parallel
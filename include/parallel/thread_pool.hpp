@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace coex::parallel {
+
+// Work-stealing pool that runs batches of tasks to completion on threads started once, when it is constructed.
+// Every worker owns a deque seeded with a contiguous block of task indices. It pops from the front of its own deque
+// and, once that runs dry, steals from the back of the others, so neighbouring tasks stay on the same worker.
+class ThreadPool {
+   public:
+    ThreadPool() : ThreadPool(default_concurrency()) {}
+
+    ThreadPool(std::size_t num_workers)
+        : m_num_workers(std::max<std::size_t>(num_workers, 1)), m_queues(m_num_workers) {
+        m_threads.reserve(m_num_workers - 1);
+        for (std::size_t worker_index = 1; worker_index < m_num_workers; ++worker_index) {
+            m_threads.emplace_back(
+                [this, worker_index](std::stop_token stop_token) { serve(stop_token, worker_index); });
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    static auto default_concurrency() -> std::size_t { return std::max(std::thread::hardware_concurrency(), 1u); }
+
+    auto num_workers() const { return m_num_workers; }
+
+    // Invoke `function(task_index, worker_index)` for every task index in [0, num_tasks). Batches run one at a time.
+    auto run(std::size_t num_tasks, auto &&function) {
+        for (std::size_t worker_index = 0; worker_index < m_num_workers; ++worker_index) {
+            for (auto task_index = num_tasks * worker_index / m_num_workers;
+                 task_index < num_tasks * (worker_index + 1) / m_num_workers; ++task_index) {
+                m_queues[worker_index].tasks.push_back(task_index);
+            }
+        }
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_function = [&](std::size_t task_index, std::size_t worker_index) { function(task_index, worker_index); };
+            m_num_busy_workers = m_num_workers - 1;
+            ++m_batch;
+        }
+        m_batch_started.notify_all();
+
+        // the calling thread works as worker 0
+        work(0);
+
+        std::unique_lock lock(m_mutex);
+        m_batch_finished.wait(lock, [&] { return !m_num_busy_workers; });
+        m_function = nullptr;
+    }
+
+   private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::size_t> tasks;
+    };
+
+    static auto pop(std::vector<Queue> &queues, std::size_t worker_index) -> std::optional<std::size_t> {
+        {
+            auto &queue = queues[worker_index];
+            std::lock_guard lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                auto task_index = queue.tasks.front();
+                queue.tasks.pop_front();
+                return task_index;
+            }
+        }
+        for (std::size_t offset = 1; offset < queues.size(); ++offset) {
+            auto &queue = queues[(worker_index + offset) % queues.size()];
+            std::lock_guard lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                auto task_index = queue.tasks.back();
+                queue.tasks.pop_back();
+                return task_index;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void work(std::size_t worker_index) {
+        while (auto task_index = pop(m_queues, worker_index)) {
+            m_function(task_index.value(), worker_index);
+        }
+    }
+
+    // Work on every batch from the first one started after this thread, until the pool is destroyed.
+    void serve(std::stop_token stop_token, std::size_t worker_index) {
+        std::size_t batch = 0;
+        while (true) {
+            std::unique_lock lock(m_mutex);
+            if (!m_batch_started.wait(lock, stop_token, [&] { return m_batch != batch; })) return;
+            batch = m_batch;
+            lock.unlock();
+
+            work(worker_index);
+
+            lock.lock();
+            if (!--m_num_busy_workers) m_batch_finished.notify_one();
+        }
+    }
+
+    std::size_t m_num_workers;
+    std::vector<Queue> m_queues;
+    std::mutex m_mutex;
+    std::condition_variable_any m_batch_started;
+    std::condition_variable m_batch_finished;
+    std::function<void(std::size_t, std::size_t)> m_function;
+    std::size_t m_num_busy_workers = 0;
+    std::size_t m_batch = 0;
+    // last, so that the threads are joined before anything they use is destroyed
+    std::vector<std::jthread> m_threads;
+};
+
+}  // namespace coex::parallel
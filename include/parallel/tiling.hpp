@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+namespace coex::parallel {
+
+// default tile extent, small enough to balance well and large enough to keep a tile's rays coherent
+inline constexpr std::size_t tile_width = 16;
+inline constexpr std::size_t tile_height = 16;
+
+struct Tile {
+    std::size_t x;
+    std::size_t y;
+    std::size_t width;
+    std::size_t height;
+};
+
+// Split a width x height region into row-major tiles; tiles on the right and bottom edges are clipped.
+constexpr auto split_tiles(std::size_t width, std::size_t height, std::size_t tile_width, std::size_t tile_height) {
+    std::vector<Tile> tiles;
+    for (std::size_t y = 0; y < height; y += tile_height) {
+        for (std::size_t x = 0; x < width; x += tile_width) {
+            tiles.push_back(Tile{x, y, std::min(tile_width, width - x), std::min(tile_height, height - y)});
+        }
+    }
+    return tiles;
+}
+
+// Invoke `function(tile, tile_index, worker_index)` for every tile of the region on the given pool, where tiles are
+// indexed as split_tiles orders them.
+auto for_each_tile(ThreadPool &thread_pool, std::size_t width, std::size_t height, std::size_t tile_width,
+                   std::size_t tile_height, auto &&function) {
+    auto tiles = split_tiles(width, height, tile_width, tile_height);
+    thread_pool.run(tiles.size(), [&](auto tile_index, auto worker_index) {
+        function(tiles[tile_index], tile_index, worker_index);
+    });
+}
+
+}  // namespace coex::parallel
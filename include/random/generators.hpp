@@ -1,6 +1,8 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <limits>
 
 namespace coex::random {
 
@@ -29,4 +31,57 @@ class LCG {
     T m_random;
 };
 
+// Counter-based generator (Philox4x32, Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+// Each output block is a pure function of a 64-bit key and a 128-bit counter, so the stream keyed by
+// (seed, pixel, sample, bounce) can be entered in O(1) by any thread and never depends on evaluation order.
+template <auto Rounds = 10>
+class Philox {
+   public:
+    static constexpr auto min = 0;
+    static constexpr auto max = std::numeric_limits<std::uint32_t>::max();
+
+    constexpr Philox() = default;
+    constexpr Philox(std::uint64_t seed, std::uint32_t pixel = 0, std::uint32_t sample = 0, std::uint32_t bounce = 0)
+        : m_key{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)},
+          m_counter{0, bounce, sample, pixel} {}
+
+    constexpr auto operator()() {
+        if (m_index == m_block.size()) {
+            m_block = generate(m_key, m_counter);
+            ++m_counter[0];
+            m_index = 0;
+        }
+        return m_block[m_index++];
+    }
+
+    // Skip the first `offset` outputs of the stream.
+    constexpr auto discard(std::uint64_t offset) {
+        offset += m_counter[0] * m_block.size() - (m_block.size() - m_index);
+        m_counter[0] = static_cast<std::uint32_t>(offset / m_block.size());
+        m_index = m_block.size();
+        for (auto index = offset % m_block.size(); index > 0; --index) {
+            (*this)();
+        }
+    }
+
+    static constexpr auto generate(std::array<std::uint32_t, 2> key, std::array<std::uint32_t, 4> counter) {
+        for (auto round = 0; round < Rounds; ++round) {
+            auto product_0 = std::uint64_t{0xD2511F53} * counter[0];
+            auto product_1 = std::uint64_t{0xCD9E8D57} * counter[2];
+            counter = {static_cast<std::uint32_t>(product_1 >> 32) ^ counter[1] ^ key[0],
+                       static_cast<std::uint32_t>(product_1),
+                       static_cast<std::uint32_t>(product_0 >> 32) ^ counter[3] ^ key[1],
+                       static_cast<std::uint32_t>(product_0)};
+            key = {key[0] + 0x9E3779B9, key[1] + 0xBB67AE85};
+        }
+        return counter;
+    }
+
+   private:
+    std::array<std::uint32_t, 2> m_key{};
+    std::array<std::uint32_t, 4> m_counter{};
+    std::array<std::uint32_t, 4> m_block{};
+    std::size_t m_index = 4;
+};
+
 }  // namespace coex::random
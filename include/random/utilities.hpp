@@ -10,7 +10,8 @@ namespace coex::random {
 template <typename Scalar, template <typename, auto> typename Vector>
 constexpr auto uniform_on_unit_circle(auto &generator) {
     auto theta = coex::random::uniform(generator, -std::numbers::pi, std::numbers::pi);
-    return Vector<Scalar, 3>{std::cos(theta), std::sin(theta), 0.0};
+    return Vector<Scalar, 3>{static_cast<Scalar>(coex::math::cos(theta)), static_cast<Scalar>(coex::math::sin(theta)),
+                             0.0};
 }
 
 template <typename Scalar, template <typename, auto> typename Vector>
@@ -24,7 +25,8 @@ constexpr auto uniform_on_unit_sphere(auto &generator) {
     auto cosine = coex::random::uniform(generator, -1.0, 1.0);
     auto sine = coex::math::sqrt(1.0 - cosine * cosine);
     auto phi = coex::random::uniform(generator, -std::numbers::pi, std::numbers::pi);
-    return Vector<Scalar, 3>{sine * std::cos(phi), sine * std::sin(phi), cosine};
+    return Vector<Scalar, 3>{static_cast<Scalar>(sine * coex::math::cos(phi)),
+                             static_cast<Scalar>(sine * coex::math::sin(phi)), static_cast<Scalar>(cosine)};
 }
 
 template <typename Scalar, template <typename, auto> typename Vector>
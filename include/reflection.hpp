@@ -1,4 +1,5 @@
 #include "reflection/dielectric.hpp"
 #include "reflection/lambertian.hpp"
+#include "reflection/materials.hpp"
 #include "reflection/metal.hpp"
 #include "reflection/utilities.hpp"
@@ -28,19 +28,19 @@ class Dielectric {
 
     constexpr auto operator()(const auto &ray, const auto &normal, auto &generator) const {
         auto cosine = -coex::tensor::dot(ray.direction(), normal);
-        auto sine = coex::math::sqrt(1.0 - cosine * cosine);
+        auto sine = coex::math::sqrt(std::max(1.0 - cosine * cosine, 0.0));
         auto inout_normal = cosine > 0 ? normal : -normal;
         auto refractive_index = cosine > 0 ? m_refractive_index : 1.0 / m_refractive_index;
         auto specular_reflectance = coex::math::square((1.0 - refractive_index) / (1.0 + refractive_index));
         auto fresnel_reflectance = schlick_approx(specular_reflectance, std::abs(cosine));
         if (sine > refractive_index || coex::random::uniform(generator, 0.0, 1.0) < fresnel_reflectance) {
-            auto reflected_position = ray.position() + 1e-6 * inout_normal;
+            auto reflected_position = offset_position(ray.position(), inout_normal);
             auto reflected_direction = reflect(ray.direction(), inout_normal);
             coex::camera::Ray<Scalar, Vector> reflected_ray(std::move(reflected_position),
                                                             std::move(reflected_direction));
             return std::make_tuple(std::move(reflected_ray), Vector<Scalar, 3>{1.0, 1.0, 1.0});
         } else {
-            auto refracted_position = ray.position() - 1e-6 * inout_normal;
+            auto refracted_position = offset_position(ray.position(), -inout_normal);
             auto refracted_direction = refract(ray.direction(), inout_normal, refractive_index);
             coex::camera::Ray<Scalar, Vector> refracted_ray(std::move(refracted_position),
                                                             std::move(refracted_direction));
@@ -22,7 +22,7 @@ class Lambertian {
     constexpr const auto &albedo() const { return m_albedo; }
 
     constexpr auto operator()(const auto &ray, const auto &normal, auto &generator) const {
-        auto scattered_position = ray.position() + 1e-6 * normal;
+        auto scattered_position = offset_position(ray.position(), normal);
         auto random_direction = coex::random::uniform_on_unit_sphere<Scalar, Vector>(generator);
         auto scattered_direction = coex::tensor::normalized(normal + random_direction);
         coex::camera::Ray<Scalar, Vector> scattered_ray(std::move(scattered_position), std::move(scattered_direction));
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "dielectric.hpp"
+#include "lambertian.hpp"
+#include "metal.hpp"
+#include "tensor.hpp"
+
+namespace coex::reflection {
+
+// The alternatives come in the same order as those of coex::geometry::Geometry.
+template <typename Scalar, template <typename, auto> typename Vector = coex::tensor::Vector>
+using Material = std::variant<Lambertian<Scalar, Vector>, Dielectric<Scalar, Vector>, Metal<Scalar, Vector>>;
+
+// Materials of a scene, indexed by the material IDs of hit records, so that shading does not need the primitive that
+// was hit. With a fixed number of materials, the table is a std::array that can be built at compile time and embedded
+// in the binary (see coex::geometry::construct_material_table).
+template <typename Scalar, template <typename, auto> typename Vector = coex::tensor::Vector,
+          std::size_t NumMaterials = std::dynamic_extent>
+class MaterialTable {
+    static constexpr auto dynamic = NumMaterials == std::dynamic_extent;
+
+    using Materials = std::conditional_t<dynamic, std::vector<Material<Scalar, Vector>>,
+                                         std::array<Material<Scalar, Vector>, NumMaterials>>;
+
+   public:
+    constexpr MaterialTable() = default;
+
+    constexpr explicit MaterialTable(std::vector<Material<Scalar, Vector>> materials)
+        requires dynamic
+        : m_materials(std::move(materials)) {}
+
+    // copy of a table into a fixed-size one
+    constexpr explicit MaterialTable(const MaterialTable<Scalar, Vector> &table)
+        requires(!dynamic)
+    {
+        std::copy(std::begin(table.materials()), std::end(table.materials()), std::begin(m_materials));
+    }
+
+    constexpr auto size() const { return std::size(m_materials); }
+
+    constexpr auto materials() const { return std::span<const Material<Scalar, Vector>>(m_materials); }
+
+    constexpr const auto &operator[](std::uint32_t material) const { return m_materials[material]; }
+
+    // alternative of the material in Material, for batching the shading by type
+    constexpr auto type(std::uint32_t material) const { return m_materials[material].index(); }
+
+    // Scatter a ray at a surface of the given material; returns the scattered ray and the reflectance.
+    constexpr auto operator()(std::uint32_t material, const auto &ray, const auto &normal, auto &generator) const {
+        return std::visit([&](const auto &material) { return material(ray, normal, generator); },
+                          m_materials[material]);
+    }
+
+   private:
+    Materials m_materials{};
+};
+
+}  // namespace coex::reflection
@@ -36,7 +36,7 @@ class Metal {
         (std::make_index_sequence<coex::tensor::dimension_v<Vector<std::complex<Scalar>, 3>, 0>>{});
         auto cosine = -coex::tensor::dot(ray.direction(), normal);
         auto fresnel_reflectance = schlick_approx(specular_reflectance, cosine);
-        auto reflected_position = ray.position() + 1e-6 * normal;
+        auto reflected_position = offset_position(ray.position(), normal);
         auto reflected_direction = reflect(ray.direction(), normal);
         auto random_direction = coex::random::uniform_in_unit_sphere<Scalar, Vector>(generator) * m_fuzziness;
         auto fuzzy_reflected_direction = coex::tensor::normalized(reflected_direction + random_direction);
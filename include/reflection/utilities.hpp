@@ -1,20 +1,33 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <numbers>
+#include <type_traits>
 
 #include "math.hpp"
 #include "tensor.hpp"
 
 namespace coex::reflection {
 
+// Move a point on a surface off it along `normal`, by a bound of the rounding error of the point, so that a ray leaving
+// from there does not start behind the surface. The error grows with the magnitude of the coordinates and with the
+// machine epsilon of the scalar type, so a fixed offset that clears it in double may not in float.
+constexpr auto offset_position(const auto &position, const auto &normal) {
+    using Scalar = std::decay_t<decltype(position[0])>;
+    auto magnitude = Scalar(1);
+    for (const auto &coordinate : position) magnitude = std::max(magnitude, std::abs(coordinate));
+    return position + normal * (32 * std::numeric_limits<Scalar>::epsilon() * magnitude);
+}
+
 constexpr auto reflect(const auto &incident, const auto &normal) {
     return incident - 2.0 * coex::tensor::dot(incident, normal) * normal;
 }
 
 constexpr auto refract(const auto &incident, const auto &normal, auto refractive_index) {
     auto parl = (incident - coex::tensor::dot(incident, normal) * normal) / refractive_index;
-    auto perp = -coex::math::sqrt(1.0 - coex::tensor::dot(parl, parl)) * normal;
+    auto perp = -coex::math::sqrt(std::max(1.0 - coex::tensor::dot(parl, parl), 0.0)) * normal;
     return parl + perp;
 }
 
@@ -1,2 +1,10 @@
+#include "rendering/checkpoint.hpp"
+#include "rendering/framebuffer.hpp"
+#include "rendering/profiling.hpp"
 #include "rendering/ray_marching.hpp"
 #include "rendering/ray_tracing.hpp"
+#include "rendering/sampling.hpp"
+#include "rendering/settings.hpp"
+#include "rendering/statistics.hpp"
+#include "rendering/tiles.hpp"
+#include "rendering/wavefront.hpp"
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#include "sampling.hpp"
+#include "settings.hpp"
+
+namespace coex::rendering {
+
+// Parameters that a checkpoint has to be resumed with, as they change the samples of a pixel. The number of samples
+// and the adaptive sampling parameters may change, so that a render can be refined. `integrator` is a hash of
+// whatever else changes the samples, such as the integrator and its parameters.
+struct CheckpointKey {
+    std::uint64_t image_width;
+    std::uint64_t image_height;
+    std::uint64_t max_depth;
+    std::uint64_t random_seed;
+    std::uint64_t russian_roulette;
+    std::uint64_t roulette_depth;
+    std::uint64_t scalar_size;
+    std::uint64_t integrator;
+
+    constexpr bool operator==(const CheckpointKey &) const = default;
+};
+
+template <typename Scalar>
+constexpr auto make_checkpoint_key(const Settings &settings, std::string_view integrator) {
+    // FNV-1a
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (auto character : integrator) {
+        hash = (hash ^ static_cast<unsigned char>(character)) * 0x100000001b3;
+    }
+    return CheckpointKey{settings.image_width,
+                         settings.image_height,
+                         settings.max_depth,
+                         settings.random_seed,
+                         settings.russian_roulette,
+                         settings.roulette_depth,
+                         sizeof(Scalar),
+                         hash};
+}
+
+// Per-pixel accumulators of the whole image in a file mapped into memory, so that every pixel finished by any thread
+// or forked worker is kept as soon as it is stored, even if the process is killed, and `flush` writes them to disk.
+// An existing file is resumed if it was made with the same key, and a new one starts with no samples anywhere.
+class Checkpoint {
+    static_assert(std::is_trivially_copyable_v<Accumulator>);
+
+   public:
+    static constexpr char magic[8] = {'C', 'O', 'E', 'X', 'A', 'C', 'C', '1'};
+
+    Checkpoint(const std::string &filename, const CheckpointKey &key)
+        : m_size(sizeof(Header) + sizeof(Accumulator) * key.image_width * key.image_height) {
+        auto descriptor = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+        if (descriptor < 0) throw std::system_error(errno, std::generic_category(), filename);
+
+        struct ::stat status;
+        auto resumed = ::fstat(descriptor, &status) == 0 && status.st_size != 0;
+        void *address = MAP_FAILED;
+        if (!resumed || static_cast<std::size_t>(status.st_size) == m_size) {
+            if (resumed || ::ftruncate(descriptor, m_size) == 0) {
+                address = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+            }
+        }
+        auto error = errno;
+        ::close(descriptor);
+        if (resumed && static_cast<std::size_t>(status.st_size) != m_size) {
+            throw std::runtime_error(filename + " is not a checkpoint of this image");
+        }
+        if (address == MAP_FAILED) throw std::system_error(error, std::generic_category(), filename);
+        m_header = static_cast<Header *>(address);
+
+        if (!resumed) {
+            // the new file reads as zeros, which are accumulators without any sample
+            std::memcpy(m_header->magic, magic, sizeof(magic));
+            m_header->key = key;
+        } else if (std::memcmp(m_header->magic, magic, sizeof(magic)) || !(m_header->key == key)) {
+            ::munmap(address, m_size);
+            throw std::runtime_error(filename + " is a checkpoint of other settings");
+        }
+    }
+
+    Checkpoint(const Checkpoint &) = delete;
+    Checkpoint &operator=(const Checkpoint &) = delete;
+
+    ~Checkpoint() {
+        flush();
+        ::munmap(m_header, m_size);
+    }
+
+    auto accumulators() { return reinterpret_cast<Accumulator *>(m_header + 1); }
+
+    void flush() { ::msync(m_header, m_size, MS_SYNC); }
+
+   private:
+    struct Header {
+        char magic[8];
+        CheckpointKey key;
+    };
+
+    std::size_t m_size;
+    Header *m_header;
+};
+
+}  // namespace coex::rendering
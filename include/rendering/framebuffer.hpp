@@ -0,0 +1,76 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "common.hpp"
+#include "parallel.hpp"
+
+namespace coex::rendering {
+
+// Pixels of a patch on the heap, in square blocks of `BlockSize` x `BlockSize` pixels that follow one another in
+// row-major order and keep their own pixels in Morton order, so that pixels close to one another in either direction
+// are close in memory. Blocks as large as the tiles of the thread pool and aligned to a cache line give every tile
+// memory of its own, which no other thread writes to. With blocks of one pixel, the pixels are in row-major order.
+template <typename T, std::size_t BlockSize = coex::parallel::tile_width,
+          typename Allocator = coex::AlignedAllocator<T>>
+class Framebuffer {
+    static_assert(std::has_single_bit(BlockSize) && BlockSize <= 256);
+
+   public:
+    static constexpr auto block_size = BlockSize;
+
+    constexpr Framebuffer(std::size_t width, std::size_t height)
+        : m_width(width),
+          m_height(height),
+          m_num_blocks_x((width + BlockSize - 1) / BlockSize),
+          m_pixels(m_num_blocks_x * ((height + BlockSize - 1) / BlockSize) * BlockSize * BlockSize) {}
+
+    constexpr auto width() const { return m_width; }
+    constexpr auto height() const { return m_height; }
+
+    constexpr auto index(std::size_t coord_x, std::size_t coord_y) const {
+        auto block_index = m_num_blocks_x * (coord_y / BlockSize) + coord_x / BlockSize;
+        return BlockSize * BlockSize * block_index + (spread(coord_x % BlockSize) | spread(coord_y % BlockSize) << 1);
+    }
+
+    constexpr auto &operator()(std::size_t coord_x, std::size_t coord_y) { return m_pixels[index(coord_x, coord_y)]; }
+
+    constexpr const auto &operator()(std::size_t coord_x, std::size_t coord_y) const {
+        return m_pixels[index(coord_x, coord_y)];
+    }
+
+    // Copy the pixels of a region row by row, as the encoders take them.
+    template <typename Iterator>
+    constexpr auto read(const coex::parallel::Tile &region, Iterator output) const {
+        for (auto coord_y = region.y; coord_y < region.y + region.height; ++coord_y) {
+            for (auto coord_x = region.x; coord_x < region.x + region.width; ++coord_x) {
+                *output++ = (*this)(coord_x, coord_y);
+            }
+        }
+        return output;
+    }
+
+    constexpr auto rows() const {
+        std::vector<T> rows(m_width * m_height);
+        read(coex::parallel::Tile{0, 0, m_width, m_height}, std::begin(rows));
+        return rows;
+    }
+
+   private:
+    // the bits of a coordinate in a block moved to the even bits, to interleave them with those of the other one
+    static constexpr std::size_t spread(std::size_t coord) {
+        coord = (coord | coord << 4) & 0x0f0f;
+        coord = (coord | coord << 2) & 0x3333;
+        return (coord | coord << 1) & 0x5555;
+    }
+
+    std::size_t m_width;
+    std::size_t m_height;
+    std::size_t m_num_blocks_x;
+    std::vector<T, Allocator> m_pixels;
+};
+
+}  // namespace coex::rendering
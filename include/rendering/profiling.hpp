@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "geometry.hpp"
+#include "parallel.hpp"
+#include "ray_tracing.hpp"
+#include "settings.hpp"
+#include "statistics.hpp"
+
+namespace coex::rendering {
+
+// Work of rendering one pixel, counted at run time to estimate what the compile-time build spends on it.
+struct PixelProfile {
+    std::size_t num_paths = 0;
+    std::size_t num_rays = 0;
+    std::size_t num_node_visits = 0;
+    std::size_t num_primitive_tests = 0;
+
+    constexpr auto &operator+=(const PixelProfile &profile) {
+        num_paths += profile.num_paths;
+        num_rays += profile.num_rays;
+        num_node_visits += profile.num_node_visits;
+        num_primitive_tests += profile.num_primitive_tests;
+        return *this;
+    }
+};
+
+// Linear model of the operations that GCC counts against -fconstexpr-ops-limit while rendering a patch, and of the
+// memory of the compiler, which keeps what the evaluation allocates until it is done.
+struct CostModel {
+    double ops_per_pixel;
+    double ops_per_path;
+    double ops_per_ray;
+    double ops_per_node_visit;
+    double ops_per_primitive_test;
+    double base_bytes;  // compiling the translation unit without rendering, scene and hierarchy included
+    double bytes_per_op;
+
+    // Operations to render a pixel whose work was profiled with `sample_ratio` times fewer samples than rendered.
+    constexpr auto ops(const PixelProfile &profile, double sample_ratio = 1.0) const {
+        return ops_per_pixel +
+               sample_ratio * (ops_per_path * profile.num_paths + ops_per_ray * profile.num_rays +
+                               ops_per_node_visit * profile.num_node_visits +
+                               ops_per_primitive_test * profile.num_primitive_tests);
+    }
+
+    constexpr auto bytes(double ops) const { return base_bytes + bytes_per_op * ops; }
+};
+
+// Estimated for GCC 12 in double precision from the loop iterations and calls that each step makes when
+// constant-evaluated: a primitive test and a node visit run a few three-element tensor loops, a ray shades and
+// scatters, and a path seeds its generators and camera ray. GCC keeps what the evaluation allocates until it is done,
+// so its memory grows with the operations. Other compilers and scenes may need other costs.
+inline constexpr CostModel gcc_cost_model{
+    .ops_per_pixel = 100.0,
+    .ops_per_path = 600.0,
+    .ops_per_ray = 400.0,
+    .ops_per_node_visit = 100.0,
+    .ops_per_primitive_test = 150.0,
+    .base_bytes = 512.0 * 1024.0 * 1024.0,
+    .bytes_per_op = 2.0,
+};
+
+// Count the work of every pixel of the patch as the compile-time build renders it: with the hierarchy, without
+// adaptive sampling or Russian roulette. Pixels are spread over a thread pool, each counting into its own profile.
+template <typename Scalar, typename Generator = coex::random::Philox<>>
+auto profile_ray_tracing(const auto &bvh, const auto &materials, const auto &camera, auto background,
+                         Settings settings) {
+    settings.relative_error = 0.0;
+    settings.russian_roulette = false;
+
+    const auto &patch = settings.patch;
+    std::vector<PixelProfile> profiles(patch.width * patch.height);
+
+    coex::parallel::ThreadPool thread_pool(settings.num_threads ? settings.num_threads
+                                                                : coex::parallel::ThreadPool::default_concurrency());
+    thread_pool.run(patch.height, [&](auto coord_y, auto) {
+        for (std::size_t coord_x = 0; coord_x < patch.width; ++coord_x) {
+            auto &profile = profiles[patch.width * coord_y + coord_x];
+
+            Statistics statistics;
+            coex::geometry::TraversalCounters counters;
+            trace_pixel<Scalar, Generator>(coex::geometry::profiled(bvh, counters), materials, camera, background,
+                                           settings, patch.x + coord_x, patch.y + coord_y, statistics);
+
+            profile.num_paths = statistics.num_paths;
+            profile.num_rays = statistics.num_rays;
+            profile.num_node_visits = counters.num_node_visits;
+            profile.num_primitive_tests = counters.num_primitive_tests;
+        }
+    });
+
+    return profiles;
+}
+
+// A way of splitting the image into patches of one size, with the cost of compiling its costliest patch.
+struct PatchPlan {
+    std::size_t patch_width;
+    std::size_t patch_height;
+    std::size_t num_patches;
+    double max_ops;
+    double max_bytes;
+};
+
+// Patch sizes that split the image evenly, as the build script expects, and whose costliest patch stays within the ops
+// limit and the memory budget, from the fewest patches to the most. Patch costs are summed over the pixel profiles of
+// the whole image, which were taken with `sample_ratio` times fewer samples than the build renders.
+inline auto plan_patches(const std::vector<PixelProfile> &profiles, std::size_t image_width, std::size_t image_height,
+                         const CostModel &model, double sample_ratio, double ops_limit, double memory_budget) {
+    // summed-area table of the operations per pixel
+    std::vector<double> table((image_width + 1) * (image_height + 1));
+    for (std::size_t coord_y = 0; coord_y < image_height; ++coord_y) {
+        for (std::size_t coord_x = 0; coord_x < image_width; ++coord_x) {
+            table[(image_width + 1) * (coord_y + 1) + coord_x + 1] =
+                model.ops(profiles[image_width * coord_y + coord_x], sample_ratio) +
+                table[(image_width + 1) * coord_y + coord_x + 1] +
+                table[(image_width + 1) * (coord_y + 1) + coord_x] - table[(image_width + 1) * coord_y + coord_x];
+        }
+    }
+    auto sum = [&](auto x, auto y, auto width, auto height) {
+        return table[(image_width + 1) * (y + height) + x + width] - table[(image_width + 1) * y + x + width] -
+               table[(image_width + 1) * (y + height) + x] + table[(image_width + 1) * y + x];
+    };
+
+    std::vector<PatchPlan> plans;
+    for (std::size_t patch_height = 1; patch_height <= image_height; ++patch_height) {
+        if (image_height % patch_height) continue;
+        for (std::size_t patch_width = 1; patch_width <= image_width; ++patch_width) {
+            if (image_width % patch_width) continue;
+
+            double max_ops = 0;
+            for (std::size_t y = 0; y < image_height; y += patch_height) {
+                for (std::size_t x = 0; x < image_width; x += patch_width) {
+                    max_ops = std::max(max_ops, sum(x, y, patch_width, patch_height));
+                }
+            }
+
+            auto max_bytes = model.bytes(max_ops);
+            if (max_ops > ops_limit || max_bytes > memory_budget) continue;
+            plans.push_back({patch_width, patch_height, image_width / patch_width * (image_height / patch_height),
+                             max_ops, max_bytes});
+        }
+    }
+
+    // fewest patches first, the squarest of them first as their pixels cost the most alike
+    auto elongation = [](const auto &plan) {
+        return static_cast<double>(std::max(plan.patch_width, plan.patch_height)) /
+               static_cast<double>(std::min(plan.patch_width, plan.patch_height));
+    };
+    std::sort(std::begin(plans), std::end(plans), [&](const auto &plan_1, const auto &plan_2) {
+        return std::tuple(plan_1.num_patches, elongation(plan_1)) < std::tuple(plan_2.num_patches, elongation(plan_2));
+    });
+    return plans;
+}
+
+}  // namespace coex::rendering
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+
+namespace coex::rendering {
+
+// Progress of a render, counted per tile without any lock: every tile is rendered by one thread or process at a time,
+// which stores its counts once done, and a reporter sums them whenever it likes. The counters live in shared memory,
+// so that tiles rendered by forked workers count as well.
+class Progress {
+   public:
+    struct Snapshot {
+        std::uint64_t num_pixels = 0;
+        std::uint64_t num_samples = 0;
+        std::uint64_t num_rays = 0;
+        std::uint64_t num_tiles = 0;
+    };
+
+    // `tiles` are the tiles in the order of their indices, in image coordinates.
+    explicit Progress(std::vector<coex::parallel::Tile> tiles)
+        : m_tiles(std::move(tiles)), m_counters(m_tiles.size()) {
+        for (const auto &tile : m_tiles) {
+            m_num_pixels += tile.width * tile.height;
+        }
+    }
+
+    const auto &tiles() const { return m_tiles; }
+
+    auto num_pixels() const { return m_num_pixels; }
+
+    // Store the counts of a finished tile; a tile that is rendered again, e.g. after its worker crashed, overwrites
+    // them.
+    auto complete(std::size_t tile_index, std::uint64_t num_samples, std::uint64_t num_rays) {
+        auto &counters = m_counters[tile_index];
+        counters.num_samples.store(num_samples, std::memory_order_relaxed);
+        counters.num_rays.store(num_rays, std::memory_order_relaxed);
+        counters.done.store(true, std::memory_order_release);
+    }
+
+    auto done(std::size_t tile_index) const { return m_counters[tile_index].done.load(std::memory_order_acquire); }
+
+    auto snapshot() const {
+        Snapshot snapshot;
+        for (std::size_t tile_index = 0; tile_index < m_tiles.size(); ++tile_index) {
+            if (!done(tile_index)) continue;
+            const auto &tile = m_tiles[tile_index];
+            const auto &counters = m_counters[tile_index];
+            snapshot.num_pixels += tile.width * tile.height;
+            snapshot.num_samples += counters.num_samples.load(std::memory_order_relaxed);
+            snapshot.num_rays += counters.num_rays.load(std::memory_order_relaxed);
+            ++snapshot.num_tiles;
+        }
+        return snapshot;
+    }
+
+   private:
+    // on a cache line of its own, as neighbouring tiles finish on different workers
+    struct alignas(64) Counters {
+        std::atomic<std::uint64_t> num_samples;
+        std::atomic<std::uint64_t> num_rays;
+        std::atomic<bool> done;
+    };
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+    std::vector<coex::parallel::Tile> m_tiles;
+    std::size_t m_num_pixels = 0;
+    coex::parallel::SharedArray<Counters> m_counters;
+};
+
+// Writer of the progress of a render every `interval` as a JSON line to a file descriptor: the counts so far, the
+// throughput since the start, the estimated time left, and the tiles completed since the previous line. Lines are
+// written by a thread of its own once started, or whenever polled after the interval, and a last line is written
+// when it is destroyed.
+class ProgressReporter {
+   public:
+    ProgressReporter(const Progress &progress, int descriptor, std::chrono::duration<double> interval)
+        : m_progress(progress),
+          m_descriptor(descriptor),
+          m_interval(interval),
+          m_reported(progress.tiles().size()),
+          m_start(std::chrono::steady_clock::now()),
+          m_last_report(m_start) {}
+
+    // A target of the form fd:<n> is an open file descriptor, and anything else a file to create.
+    ProgressReporter(const Progress &progress, const std::string &target, std::chrono::duration<double> interval)
+        : ProgressReporter(progress, open(target), interval) {
+        m_owned = !target.starts_with("fd:");
+    }
+
+    ProgressReporter(const ProgressReporter &) = delete;
+    ProgressReporter &operator=(const ProgressReporter &) = delete;
+
+    ~ProgressReporter() {
+        if (m_thread.joinable()) {
+            m_thread.request_stop();
+            m_thread.join();
+        }
+        report();
+        if (m_owned) ::close(m_descriptor);
+    }
+
+    // Write the lines on a thread of its own from now on.
+    void start() {
+        m_thread = std::jthread([this](std::stop_token stop_token) {
+            std::mutex mutex;
+            std::condition_variable_any condition_variable;
+            std::unique_lock lock(mutex);
+            while (!condition_variable.wait_for(lock, stop_token, m_interval,
+                                                [&] { return stop_token.stop_requested(); })) {
+                report();
+            }
+        });
+    }
+
+    // Write a line if the interval has passed since the previous one, for a caller that has no thread to spare.
+    void poll() {
+        if (std::chrono::steady_clock::now() - m_last_report >= m_interval) report();
+    }
+
+   private:
+    static int open(const std::string &target) {
+        if (target.starts_with("fd:")) return std::stoi(target.substr(3));
+        auto descriptor = ::open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (descriptor < 0) throw std::system_error(errno, std::generic_category(), target);
+        return descriptor;
+    }
+
+    void report() {
+        auto snapshot = m_progress.snapshot();
+        m_last_report = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration<double>(m_last_report - m_start).count();
+        auto rate = [&](auto count) { return elapsed > 0 ? static_cast<double>(count) / elapsed : 0.0; };
+        auto num_pixels_left = m_progress.num_pixels() - snapshot.num_pixels;
+
+        std::ostringstream line;
+        line << "{\"elapsed\": " << elapsed << ", \"pixels\": " << snapshot.num_pixels
+             << ", \"total_pixels\": " << m_progress.num_pixels() << ", \"tiles\": " << snapshot.num_tiles
+             << ", \"total_tiles\": " << m_progress.tiles().size() << ", \"samples\": " << snapshot.num_samples
+             << ", \"rays\": " << snapshot.num_rays << ", \"samples_per_second\": " << rate(snapshot.num_samples)
+             << ", \"mrays_per_second\": " << rate(snapshot.num_rays) / 1e6 << ", \"eta\": ";
+        if (snapshot.num_pixels && elapsed > 0) {
+            line << static_cast<double>(num_pixels_left) / rate(snapshot.num_pixels);
+        } else {
+            line << "null";
+        }
+        line << ", \"completed_tiles\": [";
+        auto first = true;
+        for (std::size_t tile_index = 0; tile_index < m_reported.size(); ++tile_index) {
+            if (m_reported[tile_index] || !m_progress.done(tile_index)) continue;
+            m_reported[tile_index] = true;
+            const auto &tile = m_progress.tiles()[tile_index];
+            line << (first ? "" : ", ") << "[" << tile.x << ", " << tile.y << ", " << tile.width << ", "
+                 << tile.height << "]";
+            first = false;
+        }
+        line << "]}\n";
+
+        auto buffer = line.str();
+        for (std::size_t offset = 0; offset < buffer.size();) {
+            auto size = ::write(m_descriptor, buffer.data() + offset, buffer.size() - offset);
+            if (size < 0 && errno == EINTR) continue;
+            if (size <= 0) break;
+            offset += size;
+        }
+    }
+
+    const Progress &m_progress;
+    int m_descriptor;
+    bool m_owned = false;
+    std::chrono::duration<double> m_interval;
+    std::vector<bool> m_reported;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_last_report;
+    std::jthread m_thread;
+};
+
+}  // namespace coex::rendering
@@ -1,83 +1,138 @@
 #pragma once
 
-#include <boost/progress.hpp>
+#include <algorithm>
+#include <cmath>
 #include <execution>
+#include <tuple>
 
 #include "math.hpp"
 #include "random.hpp"
+#include "sampling.hpp"
+#include "settings.hpp"
+#include "statistics.hpp"
 #include "tensor.hpp"
+#include "tiles.hpp"
 
 namespace coex::rendering {
 
-template <typename Scalar, auto ImageWidth, auto ImageHeight, auto PatchWidth, auto PatchHeight, auto PatchCoordX,
-          auto PatchCoordY, typename Generator = coex::random::LCG<>>
-constexpr auto ray_marching(const auto &object, const auto &camera, auto background, auto max_depth, auto num_samples,
-                            auto random_seed, const auto &bounds, auto max_step, auto epsilon) {
-#if IS_CONSTANT_EVALUATED
-#else
-    boost::progress_timer progress_timer;
-    boost::progress_display progress_display(PatchWidth * PatchHeight);
-#endif
-
-    Generator generator(random_seed);
-
-    std::vector<coex::tensor::Vector<Scalar, 2>> coords;
-    for (auto coord_y = PatchHeight * PatchCoordY; coord_y < PatchHeight * (PatchCoordY + 1); ++coord_y) {
-        for (auto coord_x = PatchWidth * PatchCoordX; coord_x < PatchWidth * (PatchCoordX + 1); ++coord_x) {
-            coords.push_back(coex::tensor::Vector<Scalar, 2>{coord_x, coord_y});
-        }
-    }
-
-    std::array<coex::tensor::Vector<Scalar, 3>, PatchWidth * PatchHeight> colors;
-    std::transform(std::begin(coords), std::end(coords), std::begin(colors), [&](const auto &coord) {
-        coex::tensor::Vector<Scalar, 3> color{};
-
-        for (auto sample_index = 0; sample_index < num_samples; ++sample_index) {
-            auto coord_u = (coord[0] + coex::random::uniform(generator, -0.5, 0.5)) / ImageWidth;
-            auto coord_v = (coord[1] + coex::random::uniform(generator, -0.5, 0.5)) / ImageHeight;
+// Sphere tracing with over-relaxation: every step goes `relaxation` times the distance to the nearest surface. When
+// the unbounding spheres of two consecutive positions turn out to be disjoint, the last step may have jumped over a
+// surface, so the ray steps back to where plain sphere tracing would have gone and stops relaxing. A surface is hit
+// once it is closer than `epsilon`, or than `pixel_epsilon` times the footprint of a pixel at the length of the path
+// so far, which saves the many steps of rays passing close to distant surfaces.
+template <typename Scalar, typename Generator = coex::random::Philox<>>
+constexpr auto ray_marching(const auto &object, const auto &materials, const auto &camera, auto background,
+                            const Settings &settings, const auto &bounds, auto max_step, auto epsilon,
+                            Scalar relaxation = 1, Scalar pixel_epsilon = 0) {
+    // angle subtended by one pixel
+    auto footprint = 2.0 * coex::math::tan(camera.vertical_fov() / 2.0) / settings.image_height;
+
+    // Every (pixel, sample, bounce) draws from its own counter-based stream, so the image does not depend on
+    // the order in which pixels are rendered nor on the number of workers.
+    auto render = [&](const Settings &settings, auto coord_x, auto coord_y, auto &statistics) constexpr {
+        auto pixel_index = settings.image_width * coord_y + coord_x;
+
+        return estimate<Scalar>(settings, pixel_index, [&](auto sample_index) constexpr {
+            Generator generator(settings.random_seed, pixel_index, sample_index, 0);
+
+            auto coord_u = (coord_x + coex::random::uniform(generator, -0.5, 0.5)) / settings.image_width;
+            auto coord_v = (coord_y + coex::random::uniform(generator, -0.5, 0.5)) / settings.image_height;
 
             auto ray = camera.ray(coord_u, coord_v, generator);
 
-            color = color + [&]() constexpr -> coex::tensor::Vector<Scalar, 3> {
+            ++statistics.num_paths;
+
+            return [&]() constexpr -> coex::tensor::Vector<Scalar, 3> {
                 coex::tensor::Vector<Scalar, 3> albedo{1.0, 1.0, 1.0};
+                Scalar path_length = 0;
+
+                for (std::size_t depth = 0; depth < settings.max_depth; ++depth) {
+                    Generator generator(settings.random_seed, pixel_index, sample_index, depth + 1);
+
+                    ++statistics.num_rays;
+
+                    // distance marched along the ray, and the radius and length of the last relaxed step
+                    Scalar marched = 0;
+                    Scalar last_radius = 0;
+                    Scalar last_step = 0;
+                    auto omega = relaxation;
+                    // A scattered ray starts on the surface it left, which it has to leave before hitting anything.
+                    auto leaving = depth > 0;
+
+                    auto hit_surface = false;
+                    for (std::size_t step = 0; step < max_step; ++step) {
+                        ++statistics.num_steps;
+
+                        auto hit = object.distance(ray.advanced(marched));
+                        auto radius = std::abs(hit.distance);
+
+                        if (radius + last_radius < last_step) {
+                            marched -= last_step - last_radius;
+                            omega = 1;
+                            last_radius = last_step = 0;
+                            continue;
+                        }
 
-                for (auto depth = 0; depth < max_depth; ++depth) {
-                    for (auto step = 0; step < max_step; ++step) {
-                        auto [geometry, distance] = object.distance(ray.position());
-
-                        ray.advance(distance);
-
-                        if (std::abs(distance) < epsilon) {
-                            std::visit(
-                                [&](auto &geometry) {
-                                    auto &material = geometry.material();
-                                    auto normal = geometry.normal(ray.position());
-                                    auto reflection = material(ray, normal, generator);
-                                    ray = std::move(std::get<0>(reflection));
-                                    albedo = albedo * std::get<1>(reflection);
-                                },
-                                geometry);
+                        auto tolerance = std::max<Scalar>(epsilon, pixel_epsilon * footprint * (path_length + marched));
+                        if (leaving) {
+                            leaving = radius < tolerance;
+                        } else if (hit && radius < tolerance) {
+                            ray.advance(marched);
+                            path_length += marched;
+
+                            auto normal = object.normal(hit.primitive, ray.position());
+                            auto reflection = materials(hit.material, ray, normal, generator);
+                            ray = std::move(std::get<0>(reflection));
+                            albedo = albedo * std::get<1>(reflection);
+                            hit_surface = true;
                             break;
-                        } else {
-                            auto [geometry, distance] = bounds.distance(ray.position());
-                            if (distance > 0.0 || step == max_step - 1) return background(ray) * albedo;
                         }
+
+                        if (bounds.distance(ray.advanced(marched)).distance > 0.0) break;
+
+                        // leave a surface by at least the tolerance at a time, as the distance to it starts from zero
+                        auto length = leaving ? std::max(radius, tolerance) : omega * radius;
+                        marched += length;
+                        last_radius = leaving || omega == 1 ? 0 : radius;
+                        last_step = leaving || omega == 1 ? 0 : length;
                     }
+
+                    if (!hit_surface) return background(ray) * albedo;
+                    if (!russian_roulette<Scalar>(settings, depth, albedo, generator)) return {};
                 }
 
                 return {};
             }();
-        }
-
-#if IS_CONSTANT_EVALUATED
-#else
-++progress_display;
-#endif
-
-        return color / num_samples;
-    });
+        });
+    };
+
+    return render_tiles<Scalar>(
+        settings,
+        [&](const Settings &settings, const auto &tile, auto &colors, auto &sample_counts, auto &statistics) constexpr {
+            const auto &patch = settings.patch;
+            for (auto coord_y = tile.y; coord_y < tile.y + tile.height; ++coord_y) {
+                for (auto coord_x = tile.x; coord_x < tile.x + tile.width; ++coord_x) {
+                    std::tie(colors(coord_x, coord_y), sample_counts(coord_x, coord_y)) =
+                        render(settings, patch.x + coord_x, patch.y + coord_y, statistics);
+                }
+            }
+        });
+}
 
-    return colors;
+template <typename Scalar, auto ImageWidth, auto ImageHeight, auto PatchWidth, auto PatchHeight, auto PatchCoordX,
+          auto PatchCoordY, typename Generator = coex::random::Philox<>>
+constexpr auto ray_marching(const auto &object, const auto &materials, const auto &camera, auto background,
+                            auto max_depth, auto num_samples, auto random_seed, const auto &bounds, auto max_step,
+                            auto epsilon, Scalar relaxation = 1, Scalar pixel_epsilon = 0) {
+    auto settings = make_settings<ImageWidth, ImageHeight, PatchWidth, PatchHeight, PatchCoordX, PatchCoordY>(
+        max_depth, num_samples, random_seed);
+    auto [colors, sample_counts, statistics] =
+        ray_marching<Scalar, Generator>(object, materials, camera, background, settings, bounds, max_step, epsilon,
+                                        relaxation, pixel_epsilon);
+
+    std::array<coex::tensor::Vector<Scalar, 3>, PatchWidth * PatchHeight> patch;
+    colors.read(coex::parallel::Tile{0, 0, PatchWidth, PatchHeight}, std::begin(patch));
+    return patch;
 }
 
 }  // namespace coex::rendering
@@ -1,77 +1,92 @@
 #pragma once
 
-#include <boost/progress.hpp>
 #include <execution>
+#include <tuple>
 
 #include "math.hpp"
 #include "random.hpp"
+#include "sampling.hpp"
+#include "settings.hpp"
+#include "statistics.hpp"
 #include "tensor.hpp"
+#include "tiles.hpp"
 
 namespace coex::rendering {
 
-template <typename Scalar, auto ImageWidth, auto ImageHeight, auto PatchWidth, auto PatchHeight, auto PatchCoordX,
-          auto PatchCoordY, typename Generator = coex::random::LCG<>>
-constexpr auto ray_tracing(const auto &object, const auto &camera, auto background, auto max_depth, auto num_samples,
-                           auto random_seed) {
-#if IS_CONSTANT_EVALUATED
-#else
-    boost::progress_timer progress_timer;
-    boost::progress_display progress_display(PatchWidth * PatchHeight);
-#endif
-
-    Generator generator(random_seed);
-
-    std::vector<coex::tensor::Vector<Scalar, 2>> coords;
-    for (auto coord_y = PatchHeight * PatchCoordY; coord_y < PatchHeight * (PatchCoordY + 1); ++coord_y) {
-        for (auto coord_x = PatchWidth * PatchCoordX; coord_x < PatchWidth * (PatchCoordX + 1); ++coord_x) {
-            coords.push_back(coex::tensor::Vector<Scalar, 2>{coord_x, coord_y});
-        }
-    }
-
-    std::array<coex::tensor::Vector<Scalar, 3>, PatchWidth * PatchHeight> colors;
-    std::transform(std::begin(coords), std::end(coords), std::begin(colors), [&](const auto &coord) {
-        coex::tensor::Vector<Scalar, 3> color{};
-
-        for (auto sample_index = 0; sample_index < num_samples; ++sample_index) {
-            auto coord_u = (coord[0] + coex::random::uniform(generator, -0.5, 0.5)) / ImageWidth;
-            auto coord_v = (coord[1] + coex::random::uniform(generator, -0.5, 0.5)) / ImageHeight;
-
-            auto ray = camera.ray(coord_u, coord_v, generator);
-
-            color = color + [&]() constexpr -> coex::tensor::Vector<Scalar, 3> {
-                coex::tensor::Vector<Scalar, 3> albedo{1.0, 1.0, 1.0};
-
-                for (auto depth = 0; depth < max_depth; ++depth) {
-                    auto [geometry, distance] = object.intersect(ray);
-
-                    if (!distance) return background(ray) * albedo;
-
-                    ray.advance(distance.value());
-
-                    std::visit(
-                        [&](auto &geometry) {
-                            auto &material = geometry.material();
-                            auto normal = geometry.normal(ray.position());
-                            auto reflection = material(ray, normal, generator);
-                            ray = std::move(std::get<0>(reflection));
-                            albedo = albedo * std::get<1>(reflection);
-                        },
-                        geometry);
-                }
+// Radiance of a pixel and the number of samples taken for it. Every (pixel, sample, bounce) draws from its own
+// counter-based stream, so the image does not depend on the order in which pixels are rendered nor on the number of
+// workers.
+template <typename Scalar, typename Generator = coex::random::Philox<>>
+constexpr auto trace_pixel(const auto &object, const auto &materials, const auto &camera, auto background,
+                           const Settings &settings, auto coord_x, auto coord_y, Statistics &statistics) {
+    auto pixel_index = settings.image_width * coord_y + coord_x;
+
+    return estimate<Scalar>(settings, pixel_index, [&](auto sample_index) constexpr {
+        Generator generator(settings.random_seed, pixel_index, sample_index, 0);
+
+        auto coord_u = (coord_x + coex::random::uniform(generator, -0.5, 0.5)) / settings.image_width;
+        auto coord_v = (coord_y + coex::random::uniform(generator, -0.5, 0.5)) / settings.image_height;
+
+        auto ray = camera.ray(coord_u, coord_v, generator);
+
+        ++statistics.num_paths;
+
+        return [&]() constexpr -> coex::tensor::Vector<Scalar, 3> {
+            coex::tensor::Vector<Scalar, 3> albedo{1.0, 1.0, 1.0};
+
+            for (std::size_t depth = 0; depth < settings.max_depth; ++depth) {
+                Generator generator(settings.random_seed, pixel_index, sample_index, depth + 1);
+
+                ++statistics.num_rays;
 
-                return {};
-            }();
-        }
+                auto hit = object.intersect(ray);
 
-#if IS_CONSTANT_EVALUATED
-#else
-++progress_display;
-#endif
+                if (!hit) return background(ray) * albedo;
 
-        return color / num_samples;
+                ray.advance(hit.distance);
+
+                auto normal = object.normal(hit.primitive, ray.position());
+                auto reflection = materials(hit.material, ray, normal, generator);
+                ray = std::move(std::get<0>(reflection));
+                albedo = albedo * std::get<1>(reflection);
+
+                if (!russian_roulette<Scalar>(settings, depth, albedo, generator)) return {};
+            }
+
+            return {};
+        }();
     });
+}
 
-    return colors;
+template <typename Scalar, typename Generator = coex::random::Philox<>>
+constexpr auto ray_tracing(const auto &object, const auto &materials, const auto &camera, auto background,
+                           const Settings &settings) {
+    return render_tiles<Scalar>(
+        settings,
+        [&](const Settings &settings, const auto &tile, auto &colors, auto &sample_counts, auto &statistics) constexpr {
+            const auto &patch = settings.patch;
+            for (auto coord_y = tile.y; coord_y < tile.y + tile.height; ++coord_y) {
+                for (auto coord_x = tile.x; coord_x < tile.x + tile.width; ++coord_x) {
+                    std::tie(colors(coord_x, coord_y), sample_counts(coord_x, coord_y)) =
+                        trace_pixel<Scalar, Generator>(object, materials, camera, background, settings,
+                                                       patch.x + coord_x, patch.y + coord_y, statistics);
+                }
+            }
+        });
+}
+
+template <typename Scalar, auto ImageWidth, auto ImageHeight, auto PatchWidth, auto PatchHeight, auto PatchCoordX,
+          auto PatchCoordY, typename Generator = coex::random::Philox<>>
+constexpr auto ray_tracing(const auto &object, const auto &materials, const auto &camera, auto background,
+                           auto max_depth, auto num_samples, auto random_seed) {
+    auto settings = make_settings<ImageWidth, ImageHeight, PatchWidth, PatchHeight, PatchCoordX, PatchCoordY>(
+        max_depth, num_samples, random_seed);
+    auto [colors, sample_counts, statistics] =
+        ray_tracing<Scalar, Generator>(object, materials, camera, background, settings);
+
+    std::array<coex::tensor::Vector<Scalar, 3>, PatchWidth * PatchHeight> patch;
+    colors.read(coex::parallel::Tile{0, 0, PatchWidth, PatchHeight}, std::begin(patch));
+    return patch;
 }
 
 }  // namespace coex::rendering
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "math.hpp"
+#include "random.hpp"
+#include "settings.hpp"
+#include "tensor.hpp"
+
+namespace coex::rendering {
+
+constexpr auto luminance(const auto &color) { return 0.2126 * color[0] + 0.7152 * color[1] + 0.0722 * color[2]; }
+
+// Running state of the estimate of one pixel: the radiance summed over its samples, their number, and Welford's online
+// mean and variance of their luminance. As every sample draws from streams keyed by its index, the number of samples
+// is also the offset from which the random streams of the pixel go on, so that an estimate can be resumed from a
+// stored state and give the same result as if it had never stopped.
+// The sums are kept in double whatever the scalar type, as float would lose the small radiances of late samples.
+struct Accumulator {
+    coex::tensor::Vector<double, 3> color{};
+    std::uint64_t num_samples = 0;
+    double mean = 0.0;
+    double squared_deviation = 0.0;
+
+    constexpr auto add(const auto &radiance) {
+        color = color + radiance;
+
+        auto value = luminance(radiance);
+        auto deviation = value - mean;
+        mean += deviation / static_cast<double>(++num_samples);
+        squared_deviation += deviation * (value - mean);
+    }
+
+    constexpr auto variance() const { return squared_deviation / static_cast<double>(num_samples - 1); }
+
+    // Errors below one 8-bit step are never visible, which keeps dark pixels from sampling forever.
+    constexpr auto tolerance(const Settings &settings) const {
+        return settings.relative_error * std::max(mean, 1.0 / 255.0);
+    }
+
+    constexpr auto converged(const Settings &settings) const {
+        if (num_samples < std::max<std::size_t>(settings.min_samples, 2)) return false;
+        auto tolerance = this->tolerance(settings);
+        return variance() <= tolerance * tolerance * static_cast<double>(num_samples);
+    }
+
+    // number of samples whose standard error would meet the tolerance, at the variance so far
+    constexpr auto needed_samples(const Settings &settings) const {
+        if (num_samples < 2) return 0.0;
+        auto tolerance = this->tolerance(settings);
+        return variance() / (tolerance * tolerance);
+    }
+};
+
+// Go on sampling the radiance returned by `trace(sample_index)` into the state of one pixel, up to `max_samples`.
+// Without adaptive sampling every pixel takes them all. Otherwise a pixel stops as soon as the standard error of its
+// mean luminance falls below `relative_error` times the mean (after at least `min_samples`). Returns the mean radiance
+// and the number of samples taken.
+template <typename Scalar>
+constexpr auto estimate(const Settings &settings, auto &&trace, Accumulator &accumulator, std::size_t max_samples) {
+    auto adaptive = settings.relative_error > 0;
+
+    while (accumulator.num_samples < max_samples && !(adaptive && accumulator.converged(settings))) {
+        accumulator.add(trace(accumulator.num_samples));
+    }
+    return std::make_tuple(coex::tensor::cast<Scalar>(accumulator.color / accumulator.num_samples),
+                           static_cast<std::size_t>(accumulator.num_samples));
+}
+
+// Average the radiance of one pixel from scratch, or from its state in the accumulators of the settings, if any. The
+// state is stored back once the pixel is done, so that the accumulators only ever hold finished estimates. A pixel
+// takes up to `num_samples` samples, the average budget per pixel, or its own number from the sample targets of the
+// budgeted second pass of adaptive sampling.
+template <typename Scalar>
+constexpr auto estimate(const Settings &settings, std::size_t pixel_index, auto &&trace) {
+    auto max_samples = settings.num_samples;
+    if (settings.relative_error > 0 && settings.max_samples) max_samples = std::min(max_samples, settings.max_samples);
+    if (settings.sample_targets) {
+        const auto &patch = settings.patch;
+        auto coord_x = pixel_index % settings.image_width - patch.x;
+        auto coord_y = pixel_index / settings.image_width - patch.y;
+        max_samples = settings.sample_targets[patch.width * coord_y + coord_x];
+    }
+
+    if (!settings.accumulators) {
+        Accumulator accumulator;
+        return estimate<Scalar>(settings, trace, accumulator, max_samples);
+    }
+    auto &stored = settings.accumulators[pixel_index - settings.accumulator_offset];
+    auto accumulator = stored;
+    auto estimation = estimate<Scalar>(settings, trace, accumulator, max_samples);
+    stored = accumulator;
+    return estimation;
+}
+
+// Numbers of samples that the budgeted second pass of adaptive sampling takes the pixels of the patch to, in row-major
+// order, from their estimates in the accumulators after the first pass. The samples that pixels saved out of the budget
+// of `num_samples` per pixel, by converging early, go to the pixels whose standard error is the largest relative to
+// their tolerance: every such pixel is brought down to the same relative error, the lowest that the budget affords,
+// taking no more than `max_samples` samples and no more than it needs to converge.
+inline auto sample_targets(const Settings &settings) {
+    const auto &patch = settings.patch;
+    std::vector<std::size_t> targets(patch.width * patch.height);
+    std::vector<double> needed_samples(targets.size());
+    std::size_t num_used = 0;
+    // the largest squared standard error relative to the tolerance, above which no pixel needs samples
+    auto max_error = 1.0;
+    for (std::size_t coord_y = 0; coord_y < patch.height; ++coord_y) {
+        for (std::size_t coord_x = 0; coord_x < patch.width; ++coord_x) {
+            auto pixel_index = settings.image_width * (patch.y + coord_y) + patch.x + coord_x;
+            const auto &accumulator = settings.accumulators[pixel_index - settings.accumulator_offset];
+            auto index = patch.width * coord_y + coord_x;
+            targets[index] = accumulator.num_samples;
+            needed_samples[index] = accumulator.needed_samples(settings);
+            num_used += accumulator.num_samples;
+            if (accumulator.num_samples) {
+                max_error = std::max(max_error, needed_samples[index] / static_cast<double>(accumulator.num_samples));
+            }
+        }
+    }
+
+    auto budget = settings.num_samples * targets.size();
+    if (num_used >= budget) return targets;
+
+    // samples that bring a pixel down to a squared relative standard error of `error`
+    auto target = [&](auto index, auto error) {
+        auto num_samples =
+            std::min(std::ceil(needed_samples[index] / error), static_cast<double>(settings.max_samples));
+        return std::max(targets[index], static_cast<std::size_t>(num_samples));
+    };
+    auto num_extra_samples = [&](auto error) {
+        std::size_t num_samples = 0;
+        for (std::size_t index = 0; index < targets.size(); ++index) {
+            num_samples += target(index, error) - targets[index];
+        }
+        return num_samples;
+    };
+
+    // bisection between the error at which every noisy pixel converges and the largest one
+    auto low = 1.0;
+    auto high = max_error;
+    if (num_extra_samples(low) <= budget - num_used) high = low;
+    for (std::size_t iteration = 0; iteration < 64 && low < high; ++iteration) {
+        auto middle = (low + high) / 2;
+        (num_extra_samples(middle) <= budget - num_used ? high : low) = middle;
+    }
+
+    for (std::size_t index = 0; index < targets.size(); ++index) {
+        targets[index] = target(index, high);
+    }
+    return targets;
+}
+
+// Russian roulette: past `roulette_depth`, a path survives a bounce with a probability equal to its largest albedo
+// component and the survivors are reweighted accordingly, which keeps the estimate unbiased. Paths whose throughput
+// has dropped to zero are always terminated. Returns whether the path goes on.
+template <typename Scalar>
+constexpr auto russian_roulette(const Settings &settings, auto depth, auto &albedo, auto &generator) {
+    if (!settings.russian_roulette || depth + 1 < settings.roulette_depth) return true;
+
+    auto probability = std::min(*std::max_element(std::begin(albedo), std::end(albedo)), Scalar(1));
+    if (probability < 1) {
+        if (coex::random::uniform(generator, 0.0, 1.0) >= probability) return false;
+        albedo = albedo / probability;
+    }
+    return true;
+}
+
+}  // namespace coex::rendering
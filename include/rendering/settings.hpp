@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "parallel.hpp"
+
+namespace coex::rendering {
+
+struct Accumulator;
+class Progress;
+
+// Runtime parameters shared by the integrators.
+struct Settings {
+    std::size_t image_width;
+    std::size_t image_height;
+    coex::parallel::Tile patch;  // region of the image to render, in pixels
+    std::size_t max_depth;
+    std::size_t num_samples;
+    std::uint64_t random_seed;
+    // adaptive sampling, disabled unless the relative error is positive
+    double relative_error = 0.0;
+    std::size_t min_samples = 16;
+    std::size_t max_samples = 0;  // 0 means num_samples, which is otherwise the average budget per pixel
+    // Russian roulette on the path throughput from the given depth on
+    bool russian_roulette = false;
+    std::size_t roulette_depth = 3;
+    // whether the wavefront integrator intersects primary rays in SIMD packets
+    bool ray_packets = false;
+    std::size_t num_threads = 0;  // 0 means one per hardware thread
+    // pool to render the tiles on, kept across renders, if any; otherwise one of `num_threads` workers per render
+    coex::parallel::ThreadPool *thread_pool = nullptr;
+    // per-pixel estimates to resume from and update, if any, of the pixels of the image in row-major order from
+    // `accumulator_offset` on
+    Accumulator *accumulators = nullptr;
+    std::size_t accumulator_offset = 0;
+    // per-pixel numbers of samples to go on to instead of num_samples, of the patch in row-major order, if any
+    const std::size_t *sample_targets = nullptr;
+    // counters of the tiles of the patch, as split by render_tiles, to store the progress into, if any
+    Progress *progress = nullptr;
+};
+
+// Settings equivalent to the compile-time patch parameters.
+template <auto ImageWidth, auto ImageHeight, auto PatchWidth, auto PatchHeight, auto PatchCoordX, auto PatchCoordY>
+constexpr auto make_settings(auto max_depth, auto num_samples, auto random_seed) {
+    return Settings{ImageWidth,
+                    ImageHeight,
+                    {PatchWidth * PatchCoordX, PatchHeight * PatchCoordY, PatchWidth, PatchHeight},
+                    static_cast<std::size_t>(max_depth),
+                    static_cast<std::size_t>(num_samples),
+                    static_cast<std::uint64_t>(random_seed)};
+}
+
+}  // namespace coex::rendering
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+namespace coex::rendering {
+
+// Counters gathered by the integrators; each worker fills its own copy and the copies are summed at the end.
+struct Statistics {
+    std::size_t num_paths = 0;
+    std::size_t num_rays = 0;
+    std::size_t num_steps = 0;  // distance evaluations of ray marching
+
+    constexpr auto &operator+=(const Statistics &statistics) {
+        num_paths += statistics.num_paths;
+        num_rays += statistics.num_rays;
+        num_steps += statistics.num_steps;
+        return *this;
+    }
+
+    // average number of rays traced per path, camera ray included
+    constexpr auto mean_path_length() const {
+        return num_paths ? static_cast<double>(num_rays) / static_cast<double>(num_paths) : 0.0;
+    }
+
+    constexpr auto mean_steps_per_ray() const {
+        return num_rays ? static_cast<double>(num_steps) / static_cast<double>(num_rays) : 0.0;
+    }
+};
+
+// Per-worker statistics on a cache line of their own.
+struct alignas(64) PaddedStatistics : Statistics {};
+
+}  // namespace coex::rendering
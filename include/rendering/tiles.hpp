@@ -0,0 +1,101 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+#include "framebuffer.hpp"
+#include "parallel.hpp"
+#include "progress.hpp"
+#include "sampling.hpp"
+#include "settings.hpp"
+#include "statistics.hpp"
+#include "tensor.hpp"
+
+namespace coex::rendering {
+
+// Buffers of render_tiles: row-major and with the standard allocator, which constant evaluation can use, at compile
+// time, and in blocks of a tile on the heap otherwise.
+#if IS_CONSTANT_EVALUATED
+template <typename T>
+using PatchBuffer = Framebuffer<T, 1, std::allocator<T>>;
+#else
+template <typename T>
+using PatchBuffer = Framebuffer<T>;
+#endif
+
+// Render the patch of the settings tile by tile, sequentially when constant-evaluated and on a thread pool otherwise.
+// `render_tile(settings, tile, colors, sample_counts, statistics)` fills the pixels of one tile, given relative to the
+// patch, into the patch-sized buffers, indexed by (x, y), as the given settings say. Returns the colors, the per-pixel
+// sample counts and the statistics of the patch.
+// When adaptive sampling lets noisy pixels take more than `num_samples` samples, the patch is rendered in two passes
+// within the budget of `num_samples` samples per pixel on average: the first one takes every pixel up to
+// `num_samples`, and the second one spends the samples that converged pixels saved on the others, as sample_targets
+// hands them out. The estimates of the pixels are kept in between, in the accumulators of the settings or in ones of
+// the patch, so that the second pass goes on from where the first one stopped.
+template <typename Scalar>
+constexpr auto render_tiles(const Settings &settings, auto &&render_tile) {
+    const auto &patch = settings.patch;
+
+    PatchBuffer<coex::tensor::Vector<Scalar, 3>> colors(patch.width, patch.height);
+    PatchBuffer<std::size_t> sample_counts(patch.width, patch.height);
+    Statistics statistics;
+
+#if IS_CONSTANT_EVALUATED
+    render_tile(settings, coex::parallel::Tile{0, 0, patch.width, patch.height}, colors, sample_counts, statistics);
+#else
+    std::optional<coex::parallel::ThreadPool> own_thread_pool;
+    if (!settings.thread_pool) {
+        own_thread_pool.emplace(settings.num_threads ? settings.num_threads
+                                                     : coex::parallel::ThreadPool::default_concurrency());
+    }
+    auto &thread_pool = settings.thread_pool ? *settings.thread_pool : *own_thread_pool;
+
+    std::vector<PaddedStatistics> worker_statistics(thread_pool.num_workers());
+    // counts of every tile over the passes, which the progress is given
+    std::vector<Statistics> tile_statistics(
+        coex::parallel::split_tiles(patch.width, patch.height, coex::parallel::tile_width, coex::parallel::tile_height)
+            .size());
+
+    auto render_pass = [&](const Settings &settings) {
+        coex::parallel::for_each_tile(
+            thread_pool, patch.width, patch.height, coex::parallel::tile_width, coex::parallel::tile_height,
+            [&](const auto &tile, auto tile_index, auto worker_index) {
+                auto &statistics = worker_statistics[worker_index];
+                Statistics previous = statistics;
+                render_tile(settings, tile, colors, sample_counts, statistics);
+
+                auto &counts = tile_statistics[tile_index];
+                counts.num_paths += statistics.num_paths - previous.num_paths;
+                counts.num_rays += statistics.num_rays - previous.num_rays;
+                if (settings.progress) settings.progress->complete(tile_index, counts.num_paths, counts.num_rays);
+            });
+    };
+
+    if (settings.relative_error > 0 && settings.max_samples > settings.num_samples) {
+        auto pass_settings = settings;
+        std::vector<Accumulator> accumulators;
+        if (!settings.accumulators) {
+            accumulators.resize(settings.image_width * patch.height);
+            pass_settings.accumulators = accumulators.data();
+            pass_settings.accumulator_offset = settings.image_width * patch.y;
+        }
+        render_pass(pass_settings);
+
+        auto targets = sample_targets(pass_settings);
+        pass_settings.sample_targets = targets.data();
+        render_pass(pass_settings);
+    } else {
+        render_pass(settings);
+    }
+
+    for (const auto &other : worker_statistics) {
+        statistics += other;
+    }
+#endif
+
+    return std::make_tuple(std::move(colors), std::move(sample_counts), statistics);
+}
+
+}  // namespace coex::rendering
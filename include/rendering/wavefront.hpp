@@ -0,0 +1,226 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "camera.hpp"
+#include "geometry.hpp"
+#include "random.hpp"
+#include "sampling.hpp"
+#include "settings.hpp"
+#include "statistics.hpp"
+#include "tensor.hpp"
+#include "tiles.hpp"
+
+namespace coex::rendering {
+
+// Rays in flight in structure-of-arrays layout, each with the throughput and the index of its path.
+template <typename Scalar, template <typename, auto> typename Vector = coex::tensor::Vector>
+class RayQueue {
+   public:
+    constexpr auto size() const { return m_paths.size(); }
+
+    constexpr auto empty() const { return m_paths.empty(); }
+
+    constexpr auto clear() {
+        for (auto component = 0; component < 3; ++component) {
+            m_positions[component].clear();
+            m_directions[component].clear();
+            m_albedos[component].clear();
+        }
+        m_paths.clear();
+    }
+
+    constexpr auto push_back(const auto &ray, const auto &albedo, std::size_t path) {
+        for (auto component = 0; component < 3; ++component) {
+            m_positions[component].push_back(ray.position()[component]);
+            m_directions[component].push_back(ray.direction()[component]);
+            m_albedos[component].push_back(albedo[component]);
+        }
+        m_paths.push_back(path);
+    }
+
+    constexpr auto ray(std::size_t index) const {
+        return coex::camera::Ray<Scalar, Vector>(
+            Vector<Scalar, 3>{m_positions[0][index], m_positions[1][index], m_positions[2][index]},
+            Vector<Scalar, 3>{m_directions[0][index], m_directions[1][index], m_directions[2][index]});
+    }
+
+    constexpr auto albedo(std::size_t index) const {
+        return Vector<Scalar, 3>{m_albedos[0][index], m_albedos[1][index], m_albedos[2][index]};
+    }
+
+    constexpr auto path(std::size_t index) const { return m_paths[index]; }
+
+   private:
+    std::array<std::vector<Scalar>, 3> m_positions;
+    std::array<std::vector<Scalar>, 3> m_directions;
+    std::array<std::vector<Scalar>, 3> m_albedos;
+    std::vector<std::size_t> m_paths;
+};
+
+// Wavefront path tracing: instead of following one path at a time, every tile traces waves of up to `wave_size`
+// paths breadth-first. Each depth first intersects all rays of the wave, then partitions the hits by material type
+// and shades every partition as one batch, so that the material code stays hot and free of unpredictable branches.
+// Random streams and summation order match ray_tracing, so both give the same image, up to rounding when the coherent
+// primary rays are intersected in SIMD packets. Every pixel takes `num_samples` samples; adaptive sampling is left to
+// the depth-first integrators.
+template <typename Scalar, typename Generator = coex::random::Philox<>>
+constexpr auto wavefront_ray_tracing(const auto &object, const auto &materials, const auto &camera, auto background,
+                                     const Settings &settings, std::size_t wave_size = 1 << 14) {
+    using Material = std::decay_t<decltype(materials[0])>;
+
+    // every pixel takes num_samples samples, so render_tiles renders in one pass whatever the adaptive settings
+    auto wavefront_settings = settings;
+    wavefront_settings.relative_error = 0.0;
+
+    return render_tiles<Scalar>(wavefront_settings, [&](const Settings &settings, const auto &tile, auto &colors,
+                                                        auto &sample_counts, auto &statistics) constexpr {
+        const auto &patch = settings.patch;
+
+        auto num_pixels = tile.width * tile.height;
+        auto num_wave_samples = std::max<std::size_t>(std::min(wave_size / num_pixels, settings.num_samples), 1);
+
+        // summed in double, as in estimate
+        std::vector<coex::tensor::Vector<double, 3>> tile_colors(num_pixels);
+        std::vector<coex::tensor::Vector<Scalar, 3>> radiances;
+        RayQueue<Scalar> rays, hit_rays;
+        std::vector<coex::geometry::Hit<Scalar>> hits;
+        std::vector<std::size_t> shading_order;
+
+        for (std::size_t first_sample = 0; first_sample < settings.num_samples; first_sample += num_wave_samples) {
+            auto wave_samples = std::min(num_wave_samples, settings.num_samples - first_sample);
+            auto num_paths = num_pixels * wave_samples;
+
+            // path `path` renders sample `first_sample + path % wave_samples` of pixel `path / wave_samples`
+            auto pixel_index = [&](auto path) {
+                auto pixel = path / wave_samples;
+                return settings.image_width * (patch.y + tile.y + pixel / tile.width) + patch.x + tile.x +
+                       pixel % tile.width;
+            };
+            auto sample_index = [&](auto path) { return first_sample + path % wave_samples; };
+
+            radiances.assign(num_paths, coex::tensor::Vector<Scalar, 3>{});
+
+            // camera rays
+            rays.clear();
+            for (std::size_t path = 0; path < num_paths; ++path) {
+                auto pixel = path / wave_samples;
+                auto coord_x = patch.x + tile.x + pixel % tile.width;
+                auto coord_y = patch.y + tile.y + pixel / tile.width;
+
+                Generator generator(settings.random_seed, pixel_index(path), sample_index(path), 0);
+
+                auto coord_u = (coord_x + coex::random::uniform(generator, -0.5, 0.5)) / settings.image_width;
+                auto coord_v = (coord_y + coex::random::uniform(generator, -0.5, 0.5)) / settings.image_height;
+
+                rays.push_back(camera.ray(coord_u, coord_v, generator), coex::tensor::Vector<Scalar, 3>{1.0, 1.0, 1.0},
+                               path);
+            }
+            statistics.num_paths += num_paths;
+
+            for (std::size_t depth = 0; depth < settings.max_depth && !rays.empty(); ++depth) {
+                // intersection: escaped rays are resolved right away, the others queue up for shading
+                hit_rays.clear();
+                hits.clear();
+                auto resolve = [&](auto index, auto ray, const auto &hit) {
+                    if (!hit) {
+                        radiances[rays.path(index)] = background(ray) * rays.albedo(index);
+                        return;
+                    }
+
+                    ray.advance(hit.distance);
+                    hit_rays.push_back(ray, rays.albedo(index), rays.path(index));
+                    hits.push_back(hit);
+                };
+
+                constexpr auto Width = coex::geometry::packet_width<Scalar>;
+                using Packet = coex::geometry::RayPacket<Scalar, Width>;
+                using PacketHit = coex::geometry::PacketHit<Scalar, Width>;
+                // every accelerator intersects packets, so that asking for them never falls back to single rays
+                static_assert(requires(Packet packet, PacketHit hit) { object.intersect(packet, hit); });
+                if (depth == 0 && settings.ray_packets) {
+                    for (std::size_t first = 0; first < rays.size(); first += Width) {
+                        Packet packet;
+                        for (std::size_t lane = 0; lane < Width && first + lane < rays.size(); ++lane) {
+                            packet.set(lane, rays.ray(first + lane));
+                        }
+
+                        PacketHit hit(packet.mask);
+                        object.intersect(packet, hit);
+
+                        for (std::size_t lane = 0; lane < Width && first + lane < rays.size(); ++lane) {
+                            resolve(first + lane, packet.ray(lane), hit.hit(lane));
+                        }
+                    }
+                } else {
+                    for (std::size_t index = 0; index < rays.size(); ++index) {
+                        auto ray = rays.ray(index);
+                        auto hit = object.intersect(ray);
+                        resolve(index, std::move(ray), hit);
+                    }
+                }
+                statistics.num_rays += rays.size();
+
+                // partition the hits by material type with a counting sort
+                std::array<std::size_t, std::variant_size_v<Material> + 1> offsets{};
+                for (const auto &hit : hits) {
+                    ++offsets[materials.type(hit.material) + 1];
+                }
+                for (std::size_t type = 1; type < offsets.size(); ++type) {
+                    offsets[type] += offsets[type - 1];
+                }
+                shading_order.resize(hits.size());
+                auto positions = offsets;
+                for (std::size_t index = 0; index < hits.size(); ++index) {
+                    shading_order[positions[materials.type(hits[index].material)]++] = index;
+                }
+
+                // shading, one batch per material type
+                rays.clear();
+                [&]<auto... Types>(std::index_sequence<Types...>) constexpr {
+                    (
+                        [&]() constexpr {
+                            for (auto order = offsets[Types]; order < offsets[Types + 1]; ++order) {
+                                auto index = shading_order[order];
+                                auto path = hit_rays.path(index);
+                                const auto &hit = hits[index];
+                                const auto &material = std::get<Types>(materials[hit.material]);
+
+                                Generator generator(settings.random_seed, pixel_index(path), sample_index(path),
+                                                    depth + 1);
+
+                                auto ray = hit_rays.ray(index);
+                                auto normal = object.normal(hit.primitive, ray.position());
+                                auto [reflected_ray, reflectance] = material(ray, normal, generator);
+                                auto albedo = hit_rays.albedo(index) * reflectance;
+
+                                if (russian_roulette<Scalar>(settings, depth, albedo, generator)) {
+                                    rays.push_back(reflected_ray, albedo, path);
+                                }
+                            }
+                        }(),
+                        ...);
+                }(std::make_index_sequence<std::variant_size_v<Material>>{});
+            }
+
+            // accumulate in sample order, as ray_tracing does
+            for (std::size_t path = 0; path < num_paths; ++path) {
+                tile_colors[path / wave_samples] = tile_colors[path / wave_samples] + radiances[path];
+            }
+        }
+
+        for (std::size_t pixel = 0; pixel < num_pixels; ++pixel) {
+            auto coord_x = tile.x + pixel % tile.width;
+            auto coord_y = tile.y + pixel / tile.width;
+            colors(coord_x, coord_y) = coex::tensor::cast<Scalar>(tile_colors[pixel] / settings.num_samples);
+            sample_counts(coord_x, coord_y) = settings.num_samples;
+        }
+    });
+}
+
+}  // namespace coex::rendering
@@ -1,2 +1,3 @@
+#include "tensor/dynamic.hpp"
 #include "tensor/matrix.hpp"
 #include "tensor/tensor.hpp"
@@ -0,0 +1,435 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "math.hpp"
+#include "tensor.hpp"
+
+namespace coex::tensor {
+
+// ================================================================
+// class
+
+// View of a tensor of rank `Rank` through the strides of its axes, which indexes its first axis into views of the
+// sub-tensors without copying them.
+template <typename T, std::size_t Rank>
+class DynamicTensorView {
+   public:
+    using value_type = std::remove_const_t<T>;
+    using Shape = std::array<std::size_t, Rank>;
+
+    constexpr DynamicTensorView(T *data, const Shape &shape, const Shape &strides)
+        : m_data(data), m_shape(shape), m_strides(strides) {}
+
+    constexpr auto data() const { return m_data; }
+
+    constexpr const auto &shape() const { return m_shape; }
+
+    constexpr const auto &strides() const { return m_strides; }
+
+    constexpr auto dimension(std::size_t axis) const { return m_shape[axis]; }
+
+    constexpr auto size() const {
+        std::size_t size = 1;
+        for (auto dimension : m_shape) size *= dimension;
+        return size;
+    }
+
+    constexpr decltype(auto) operator[](std::size_t index) const {
+        if constexpr (Rank == 1) {
+            return m_data[index * m_strides[0]];
+        } else {
+            return DynamicTensorView<T, Rank - 1>(m_data + index * m_strides[0], tail(m_shape), tail(m_strides));
+        }
+    }
+
+    constexpr auto &operator()(std::integral auto... indices) const
+        requires(sizeof...(indices) == Rank)
+    {
+        return [&]<auto... Is>(std::index_sequence<Is...>)->auto & {
+            return m_data[(0 + ... + (static_cast<std::size_t>(indices) * m_strides[Is]))];
+        }
+        (std::make_index_sequence<Rank>{});
+    }
+
+   private:
+    static constexpr auto tail(const Shape &shape) {
+        return [&]<auto... Is>(std::index_sequence<Is...>)->std::array<std::size_t, Rank - 1> {
+            return {shape[Is + 1]...};
+        }
+        (std::make_index_sequence<Rank - 1>{});
+    }
+
+    T *m_data;
+    Shape m_shape;
+    Shape m_strides;
+};
+
+// Allocator that default-initializes the elements it constructs without arguments, so that storage about to be
+// overwritten is not zero-filled first. Elements constructed from a value are left to `Allocator`.
+template <typename Allocator>
+struct DefaultInitAllocator : Allocator {
+    template <typename U>
+    struct rebind {
+        using other = DefaultInitAllocator<typename std::allocator_traits<Allocator>::template rebind_alloc<U>>;
+    };
+
+    DefaultInitAllocator() = default;
+
+    DefaultInitAllocator(const Allocator &allocator) : Allocator(allocator) {}
+
+    template <typename U>
+    auto construct(U *pointer) noexcept(std::is_nothrow_default_constructible_v<U>) {
+        ::new (static_cast<void *>(pointer)) U;
+    }
+
+    template <typename U, typename... Args>
+    auto construct(U *pointer, Args &&...args) {
+        std::allocator_traits<Allocator>::construct(*this, pointer, std::forward<Args>(args)...);
+    }
+};
+
+// Tensor of a rank fixed at compile time and a shape given at run time, e.g. for buffers as large as a frame. Its
+// elements are stored in row-major order in one allocation, aligned to a cache line by default, so that operations
+// on whole tensors are flat loops over contiguous memory. Any other allocator may be given instead, such as a
+// std::pmr::polymorphic_allocator over an arena for short-lived tensors.
+template <typename T, std::size_t Rank, typename Allocator = coex::AlignedAllocator<T>>
+class DynamicTensor {
+    static_assert(Rank > 0);
+
+   public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using Shape = std::array<std::size_t, Rank>;
+
+    DynamicTensor() : DynamicTensor(Shape{}) {}
+
+    explicit DynamicTensor(const Shape &shape, const Allocator &allocator = Allocator())
+        : DynamicTensor(shape, T{}, allocator) {}
+
+    DynamicTensor(const Shape &shape, const T &value, const Allocator &allocator = Allocator())
+        : m_shape(shape), m_strides(row_major_strides(shape)), m_elements(m_strides[0] * shape[0], value, allocator) {}
+
+    // A tensor whose elements are left default-initialized, for operations that write every one of them.
+    static auto uninitialized(const Shape &shape, const Allocator &allocator = Allocator()) {
+        return DynamicTensor(shape, allocator, Uninitialized{});
+    }
+
+    auto data() { return m_elements.data(); }
+    auto data() const { return m_elements.data(); }
+
+    const auto &shape() const { return m_shape; }
+
+    const auto &strides() const { return m_strides; }
+
+    auto dimension(std::size_t axis) const { return m_shape[axis]; }
+
+    auto size() const { return m_elements.size(); }
+
+    auto get_allocator() const { return static_cast<Allocator>(m_elements.get_allocator()); }
+
+    // the elements in memory order, regardless of the shape
+    auto begin() { return m_elements.begin(); }
+    auto begin() const { return m_elements.begin(); }
+    auto end() { return m_elements.end(); }
+    auto end() const { return m_elements.end(); }
+
+    auto view() { return DynamicTensorView<T, Rank>(data(), m_shape, m_strides); }
+    auto view() const { return DynamicTensorView<const T, Rank>(data(), m_shape, m_strides); }
+
+    decltype(auto) operator[](std::size_t index) { return view()[index]; }
+    decltype(auto) operator[](std::size_t index) const { return view()[index]; }
+
+    auto &operator()(std::integral auto... indices)
+        requires(sizeof...(indices) == Rank)
+    {
+        return view()(indices...);
+    }
+
+    const auto &operator()(std::integral auto... indices) const
+        requires(sizeof...(indices) == Rank)
+    {
+        return view()(indices...);
+    }
+
+   private:
+    struct Uninitialized {};
+
+    DynamicTensor(const Shape &shape, const Allocator &allocator, Uninitialized)
+        : m_shape(shape), m_strides(row_major_strides(shape)), m_elements(m_strides[0] * shape[0], allocator) {}
+
+    static auto row_major_strides(const Shape &shape) {
+        Shape strides;
+        std::size_t stride = 1;
+        for (auto axis = Rank; axis-- > 0;) {
+            strides[axis] = stride;
+            stride *= shape[axis];
+        }
+        return strides;
+    }
+
+    Shape m_shape;
+    Shape m_strides;
+    std::vector<T, DefaultInitAllocator<Allocator>> m_elements;
+};
+
+// ================================================================
+// concept
+
+template <typename T>
+struct is_dynamic_tensor : std::false_type {};
+
+template <typename T, std::size_t Rank, typename Allocator>
+struct is_dynamic_tensor<DynamicTensor<T, Rank, Allocator>> : std::true_type {};
+
+template <typename T>
+concept DynamicShaped = is_dynamic_tensor<std::remove_cvref_t<T>>::value;
+
+// Anything else than a dynamic tensor combines with every one of its elements.
+template <typename T>
+concept DynamicScalar = !DynamicShaped<T> && ScalarShaped<T>;
+
+template <typename T, std::size_t Rank, typename Allocator, typename U>
+struct rebind<DynamicTensor<T, Rank, Allocator>, U> {
+    using type = DynamicTensor<U, Rank, typename std::allocator_traits<Allocator>::template rebind_alloc<U>>;
+};
+
+// ================================================================
+// elementwise operations
+
+template <DynamicShaped Tensor>
+auto cast_dynamic_scalar(auto scalar) {
+    using Precision = typename precision<typename Tensor::value_type>::type;
+    if constexpr (std::is_arithmetic_v<decltype(scalar)> && std::is_arithmetic_v<Precision>) {
+        return static_cast<Precision>(scalar);
+    } else {
+        return scalar;
+    }
+}
+
+// A tensor of the shape and type of `tensor`, with `function` applied to its elements and those of `operand` at the
+// same positions, or `operand` itself if it is a scalar.
+template <DynamicShaped Tensor>
+auto combine(const Tensor &tensor, const auto &operand, auto function) {
+    auto result = Tensor::uninitialized(tensor.shape(), tensor.get_allocator());
+    auto elements = result.data();
+    auto tensor_elements = tensor.data();
+    if constexpr (DynamicShaped<decltype(operand)>) {
+        if (operand.shape() != tensor.shape()) throw std::invalid_argument("tensors of different shapes");
+        auto operand_elements = operand.data();
+        for (std::size_t index = 0; index < result.size(); ++index) {
+            elements[index] = function(tensor_elements[index], operand_elements[index]);
+        }
+    } else {
+        auto value = cast_dynamic_scalar<Tensor>(operand);
+        for (std::size_t index = 0; index < result.size(); ++index) {
+            elements[index] = function(tensor_elements[index], value);
+        }
+    }
+    return result;
+}
+
+// `function` with its arguments swapped, for scalars on the left
+constexpr auto flipped(auto function) {
+    return [=](const auto &x, const auto &y) { return function(y, x); };
+}
+
+// ----------------------------------------------------------------
+// addition
+
+template <DynamicShaped Tensor1, DynamicShaped Tensor2>
+auto operator+(const Tensor1 &tensor_1, const Tensor2 &tensor_2) {
+    return combine(tensor_1, tensor_2, std::plus<>());
+}
+
+template <DynamicShaped Tensor, DynamicScalar Scalar>
+auto operator+(const Tensor &tensor, Scalar scalar) {
+    return combine(tensor, scalar, std::plus<>());
+}
+
+template <DynamicShaped Tensor, DynamicScalar Scalar>
+auto operator+(Scalar scalar, const Tensor &tensor) {
+    return combine(tensor, scalar, flipped(std::plus<>()));
+}
+
+// ----------------------------------------------------------------
+// subtraction
+
+template <DynamicShaped Tensor1, DynamicShaped Tensor2>
+auto operator-(const Tensor1 &tensor_1, const Tensor2 &tensor_2) {
+    return combine(tensor_1, tensor_2, std::minus<>());
+}
+
+template <DynamicShaped Tensor, DynamicScalar Scalar>
+auto operator-(const Tensor &tensor, Scalar scalar) {
+    return combine(tensor, scalar, std::minus<>());
+}
+
+template <DynamicShaped Tensor, DynamicScalar Scalar>
+auto operator-(Scalar scalar, const Tensor &tensor) {
+    return combine(tensor, scalar, flipped(std::minus<>()));
+}
+
+// ----------------------------------------------------------------
+// multiplication
+
+template <DynamicShaped Tensor1, DynamicShaped Tensor2>
+auto operator*(const Tensor1 &tensor_1, const Tensor2 &tensor_2) {
+    return combine(tensor_1, tensor_2, std::multiplies<>());
+}
+
+template <DynamicShaped Tensor, DynamicScalar Scalar>
+auto operator*(const Tensor &tensor, Scalar scalar) {
+    return combine(tensor, scalar, std::multiplies<>());
+}
+
+template <DynamicShaped Tensor, DynamicScalar Scalar>
+auto operator*(Scalar scalar, const Tensor &tensor) {
+    return combine(tensor, scalar, flipped(std::multiplies<>()));
+}
+
+// ----------------------------------------------------------------
+// division
+
+template <DynamicShaped Tensor1, DynamicShaped Tensor2>
+auto operator/(const Tensor1 &tensor_1, const Tensor2 &tensor_2) {
+    return combine(tensor_1, tensor_2, std::divides<>());
+}
+
+template <DynamicShaped Tensor, DynamicScalar Scalar>
+auto operator/(const Tensor &tensor, Scalar scalar) {
+    return combine(tensor, scalar, std::divides<>());
+}
+
+template <DynamicShaped Tensor, DynamicScalar Scalar>
+auto operator/(Scalar scalar, const Tensor &tensor) {
+    return combine(tensor, scalar, flipped(std::divides<>()));
+}
+
+// ================================================================
+// dot
+
+// sum along the first axis, in the order of the generic `sum`
+template <typename T, std::size_t Rank, typename Allocator>
+auto sum(const DynamicTensor<T, Rank, Allocator> &tensor) {
+    if constexpr (Rank == 1) {
+        auto sum = T{};
+        for (const auto &element : tensor) sum = sum + element;
+        return sum;
+    } else {
+        auto shape = tensor.view()[0].shape();
+        if (!tensor.dimension(0)) return DynamicTensor<T, Rank - 1, Allocator>(shape, tensor.get_allocator());
+        // the first sub-tensor starts the sums, which need no zeros beforehand
+        auto sum = DynamicTensor<T, Rank - 1, Allocator>::uninitialized(shape, tensor.get_allocator());
+        auto sums = sum.data();
+        for (std::size_t offset = 0; offset < sum.size(); ++offset) {
+            sums[offset] = T{} + tensor.data()[offset];
+        }
+        for (std::size_t index = 1; index < tensor.dimension(0); ++index) {
+            auto elements = tensor.data() + index * tensor.strides()[0];
+            for (std::size_t offset = 0; offset < sum.size(); ++offset) {
+                sums[offset] = sums[offset] + elements[offset];
+            }
+        }
+        return sum;
+    }
+}
+
+// the products folded in the order of `sum`, in one pass over both tensors without a tensor of them in between
+template <typename T, std::size_t Rank, typename Allocator, DynamicShaped Tensor>
+auto dot(const DynamicTensor<T, Rank, Allocator> &tensor_1, const Tensor &tensor_2) {
+    if (tensor_1.shape() != tensor_2.shape()) throw std::invalid_argument("tensors of different shapes");
+    auto elements_1 = tensor_1.data();
+    auto elements_2 = tensor_2.data();
+    if constexpr (Rank == 1) {
+        auto sum = T{};
+        for (std::size_t index = 0; index < tensor_1.size(); ++index) {
+            sum = sum + static_cast<T>(elements_1[index] * elements_2[index]);
+        }
+        return sum;
+    } else {
+        auto shape = tensor_1.view()[0].shape();
+        if (!tensor_1.dimension(0)) return DynamicTensor<T, Rank - 1, Allocator>(shape, tensor_1.get_allocator());
+        auto sum = DynamicTensor<T, Rank - 1, Allocator>::uninitialized(shape, tensor_1.get_allocator());
+        auto sums = sum.data();
+        for (std::size_t offset = 0; offset < sum.size(); ++offset) {
+            sums[offset] = T{} + static_cast<T>(elements_1[offset] * elements_2[offset]);
+        }
+        for (std::size_t index = 1; index < tensor_1.dimension(0); ++index) {
+            auto offset_1 = elements_1 + index * tensor_1.strides()[0];
+            auto offset_2 = elements_2 + index * tensor_2.strides()[0];
+            for (std::size_t offset = 0; offset < sum.size(); ++offset) {
+                sums[offset] = sums[offset] + static_cast<T>(offset_1[offset] * offset_2[offset]);
+            }
+        }
+        return sum;
+    }
+}
+
+// ================================================================
+// transpose
+
+// the first two axes swapped, into contiguous storage
+template <typename T, std::size_t Rank, typename Allocator>
+    requires(Rank >= 2)
+auto transposed(const DynamicTensor<T, Rank, Allocator> &tensor) {
+    auto shape = tensor.shape();
+    std::swap(shape[0], shape[1]);
+    auto result = DynamicTensor<T, Rank, Allocator>::uninitialized(shape, tensor.get_allocator());
+    auto block_size = tensor.strides()[1];
+    for (std::size_t row = 0; row < tensor.dimension(0); ++row) {
+        for (std::size_t column = 0; column < tensor.dimension(1); ++column) {
+            std::copy_n(tensor.data() + row * tensor.strides()[0] + column * block_size, block_size,
+                        result.data() + column * result.strides()[0] + row * block_size);
+        }
+    }
+    return result;
+}
+
+// ================================================================
+// norm
+
+template <typename T, typename Allocator>
+auto norm(const DynamicTensor<T, 1, Allocator> &tensor) {
+    return coex::math::sqrt(dot(tensor, tensor));
+}
+
+template <typename T, typename Allocator>
+auto normalized(const DynamicTensor<T, 1, Allocator> &tensor) {
+    return tensor / norm(tensor);
+}
+
+// ================================================================
+// cast
+
+template <typename U, DynamicShaped Tensor>
+auto cast(const Tensor &tensor) {
+    auto result = rebind_t<Tensor, U>::uninitialized(tensor.shape(), tensor.get_allocator());
+    std::transform(std::begin(tensor), std::end(tensor), std::begin(result),
+                   [](const auto &element) { return static_cast<U>(element); });
+    return result;
+}
+
+// ================================================================
+// elemwise
+
+template <typename Function, typename Tensor>
+    requires DynamicShaped<Tensor>
+auto elemwise(Function &&function, Tensor &&tensor) {
+    auto result = std::remove_cvref_t<Tensor>::uninitialized(tensor.shape(), tensor.get_allocator());
+    std::transform(std::begin(tensor), std::end(tensor), std::begin(result),
+                   [&](const auto &element) { return elemwise(function, element); });
+    return result;
+}
+
+}  // namespace coex::tensor
@@ -2,9 +2,9 @@
 
 #include <array>
 #include <cmath>
+#include <complex>
 #include <numeric>
 #include <type_traits>
-#include <vector>
 
 #include "common.hpp"
 #include "math.hpp"
@@ -35,18 +35,6 @@ using Vector = Tensor<T, N>;
 template <typename T, auto M, auto N>
 using Matrix = Tensor<T, M, N>;
 
-// ----------------------------------------------------------------
-
-template <typename T, auto N>
-struct vector : std::vector<T> {
-    using std::vector<T>::vector;
-    constexpr vector() : vector(N) {}
-    constexpr vector(const std::allocator<T> &allocator) : vector(N, allocator) {}
-};
-
-template <typename T, auto... Ns>
-using DynamicTensor = GenericTensor<vector, T, Ns...>;
-
 // ================================================================
 // rank
 
@@ -94,6 +82,20 @@ struct element<GenericTensor<Array, T, N>, 0> {
 template <typename T, auto I>
 using element_t = typename element<T, I>::type;
 
+// ================================================================
+// rebind
+
+template <typename T, typename U>
+struct rebind;
+
+template <template <typename, auto> typename Array, typename T, auto... Ns, typename U>
+struct rebind<GenericTensor<Array, T, Ns...>, U> {
+    using type = GenericTensor<Array, U, Ns...>;
+};
+
+template <typename T, typename U>
+using rebind_t = typename rebind<T, U>::type;
+
 // ================================================================
 // concept
 
@@ -112,6 +114,30 @@ concept TensorShaped = (rank_v<T> > 0);
 template <typename T, typename U>
 concept Broadcastable = (dimension_v<T, 0> == dimension_v<U, 0>);
 
+// ================================================================
+// precision
+
+// Scalars combined with a tensor take the precision of its elements, so that a tensor of floats is not computed in
+// double and narrowed back.
+template <typename T>
+struct precision {
+    using type = T;
+};
+
+template <typename T>
+struct precision<std::complex<T>> {
+    using type = T;
+};
+
+template <typename Tensor, typename Scalar>
+constexpr auto cast_scalar(Scalar scalar) {
+    if constexpr (VectorShaped<Tensor> && std::is_arithmetic_v<Scalar>) {
+        return static_cast<typename precision<element_t<Tensor, 0>>::type>(scalar);
+    } else {
+        return scalar;
+    }
+}
+
 // ================================================================
 // addition
 
@@ -125,13 +151,15 @@ constexpr auto operator+(const Tensor1 &tensor_1, const Tensor2 &tensor_2)
 
 template <TensorShaped Tensor, ScalarShaped Scalar>
 constexpr auto operator+(const Tensor &tensor, Scalar scalar) {
-    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(tensor[Is] + scalar)...}; }
+    auto value = cast_scalar<Tensor>(scalar);
+    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(tensor[Is] + value)...}; }
     (std::make_index_sequence<dimension_v<Tensor, 0>>{});
 }
 
 template <TensorShaped Tensor, ScalarShaped Scalar>
 constexpr auto operator+(Scalar scalar, const Tensor &tensor) {
-    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(scalar + tensor[Is])...}; }
+    auto value = cast_scalar<Tensor>(scalar);
+    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(value + tensor[Is])...}; }
     (std::make_index_sequence<dimension_v<Tensor, 0>>{});
 }
 
@@ -150,13 +178,15 @@ constexpr auto operator-(const Tensor1 &tensor_1, const Tensor2 &tensor_2)
 
 template <TensorShaped Tensor, ScalarShaped Scalar>
 constexpr auto operator-(const Tensor &tensor, Scalar scalar) {
-    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(tensor[Is] - scalar)...}; }
+    auto value = cast_scalar<Tensor>(scalar);
+    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(tensor[Is] - value)...}; }
     (std::make_index_sequence<dimension_v<Tensor, 0>>{});
 }
 
 template <TensorShaped Tensor, ScalarShaped Scalar>
 constexpr auto operator-(Scalar scalar, const Tensor &tensor) {
-    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(scalar - tensor[Is])...}; }
+    auto value = cast_scalar<Tensor>(scalar);
+    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(value - tensor[Is])...}; }
     (std::make_index_sequence<dimension_v<Tensor, 0>>{});
 }
 
@@ -175,13 +205,15 @@ constexpr auto operator*(const Tensor1 &tensor_1, const Tensor2 &tensor_2)
 
 template <TensorShaped Tensor, ScalarShaped Scalar>
 constexpr auto operator*(const Tensor &tensor, Scalar scalar) {
-    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(tensor[Is] * scalar)...}; }
+    auto value = cast_scalar<Tensor>(scalar);
+    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(tensor[Is] * value)...}; }
     (std::make_index_sequence<dimension_v<Tensor, 0>>{});
 }
 
 template <TensorShaped Tensor, ScalarShaped Scalar>
 constexpr auto operator*(Scalar scalar, const Tensor &tensor) {
-    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(scalar * tensor[Is])...}; }
+    auto value = cast_scalar<Tensor>(scalar);
+    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(value * tensor[Is])...}; }
     (std::make_index_sequence<dimension_v<Tensor, 0>>{});
 }
 
@@ -198,13 +230,15 @@ constexpr auto operator/(const Tensor1 &tensor_1, const Tensor2 &tensor_2)
 
 template <TensorShaped Tensor, ScalarShaped Scalar>
 constexpr auto operator/(const Tensor &tensor, Scalar scalar) {
-    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(tensor[Is] / scalar)...}; }
+    auto value = cast_scalar<Tensor>(scalar);
+    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(tensor[Is] / value)...}; }
     (std::make_index_sequence<dimension_v<Tensor, 0>>{});
 }
 
 template <TensorShaped Tensor, ScalarShaped Scalar>
 constexpr auto operator/(Scalar scalar, const Tensor &tensor) {
-    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(scalar / tensor[Is])...}; }
+    auto value = cast_scalar<Tensor>(scalar);
+    return [&]<auto... Is>(std::index_sequence<Is...>)->Tensor { return {(value / tensor[Is])...}; }
     (std::make_index_sequence<dimension_v<Tensor, 0>>{});
 }
 
@@ -220,7 +254,11 @@ template <TensorShaped Tensor1, TensorShaped Tensor2>
 constexpr auto dot(const Tensor1 &tensor_1, const Tensor2 &tensor_2)
     requires Broadcastable<Tensor1, Tensor2>
 {
-    return sum(tensor_1 * tensor_2);
+    // the products folded in the order of `sum`, without a tensor of them in between
+    return [&]<auto... Is>(std::index_sequence<Is...>)->element_t<Tensor1, 0> {
+        return (element_t<Tensor1, 0>{} + ... + (tensor_1[Is] * tensor_2[Is]));
+    }
+    (std::make_index_sequence<dimension_v<Tensor1, 0>>{});
 }
 
 // ================================================================
@@ -258,6 +296,21 @@ constexpr auto norm(const TensorShaped auto &tensor) { return coex::math::sqrt(d
 
 constexpr auto normalized(const TensorShaped auto &tensor) { return tensor / norm(tensor); }
 
+// ================================================================
+// cast
+
+template <typename T, TensorShaped Tensor>
+constexpr auto cast(const Tensor &tensor) {
+    return [&]<auto... Is>(std::index_sequence<Is...>)->rebind_t<Tensor, T> {
+        if constexpr (VectorShaped<Tensor>) {
+            return {static_cast<T>(tensor[Is])...};
+        } else {
+            return {cast<T>(tensor[Is])...};
+        }
+    }
+    (std::make_index_sequence<dimension_v<Tensor, 0>>{});
+}
+
 // ================================================================
 // elemwise
 
@@ -27,7 +27,7 @@ def main(args):
         else:
             processes.clear()
 
-    def create_coroutine(program):
+    def create_coroutine(program, patch_coords=None):
 
         async def coroutine():
 
@@ -66,7 +66,10 @@ def main(args):
 
                 return (patch_coord_x, patch_coord_y), process
 
-            patch_coords_y, patch_coords_x = zip(*itertools.product(range(args.image_height // args.patch_height), range(args.image_width // args.patch_width)))
+            if patch_coords:
+                patch_coords_x, patch_coords_y = zip(*patch_coords)
+            else:
+                patch_coords_y, patch_coords_x = zip(*itertools.product(range(args.image_height // args.patch_height), range(args.image_width // args.patch_width)))
             subtasks = list(map(asyncio.create_task, map(subcoroutine, patch_coords_x, patch_coords_y)))
 
             for subtask in asyncio.as_completed(subtasks):
@@ -95,12 +98,36 @@ def main(args):
 
     print(json.dumps(vars(args), indent=4))
 
+    # without compile-time ray tracing, a single build renders every patch given on its command line
+    if args.constexpr:
+        build_coords = None
+        build_directory = lambda patch_coord_x, patch_coord_y: f"build/patch_{patch_coord_x}_{patch_coord_y}"
+        program = lambda patch_coord_x, patch_coord_y: f"srun {build_directory(patch_coord_x, patch_coord_y)}/ray_tracing"
+    else:
+        build_coords = [(0, 0)]
+        build_directory = lambda patch_coord_x, patch_coord_y: "build/runtime"
+        program = lambda patch_coord_x, patch_coord_y: textwrap.dedent(f"""\
+            srun build/runtime/ray_tracing \\
+                --image_width {args.image_width} \\
+                --image_height {args.image_height} \\
+                --patch_width {args.patch_width} \\
+                --patch_height {args.patch_height} \\
+                --patch_coord_x {patch_coord_x} \\
+                --patch_coord_y {patch_coord_y} \\
+                --max_depth {args.max_depth} \\
+                --num_samples {args.num_samples} \\
+                --random_seed {args.random_seed} \\
+                --image_output outputs/image.ppm \\
+                --progress fd:1
+        """)
+
     print(f"\n================================ CMake ================================")
 
     if (asyncio.run(create_coroutine(lambda patch_coord_x, patch_coord_y: textwrap.dedent(f"""\
         srun cmake \\
             -D CMAKE_BUILD_TYPE=Release \\
             -D CONSTEXPR={"ON" if args.constexpr else "OFF"} \\
+            -D SCALAR={args.scalar} \\
             -D IMAGE_WIDTH={args.image_width} \\
             -D IMAGE_HEIGHT={args.image_height} \\
             -D PATCH_WIDTH={args.patch_width} \\
@@ -111,8 +138,8 @@ def main(args):
             -D NUM_SAMPLES={args.num_samples} \\
             -D RANDOM_SEED={args.random_seed} \\
             -S {os.path.dirname(os.path.abspath(__file__))} \\
-            -B build/patch_{patch_coord_x}_{patch_coord_y}
-    """))())):
+            -B {build_directory(patch_coord_x, patch_coord_y)}
+    """), build_coords)())):
 
         print(f"\n================================ CMake ================================")
         print(">>> Succeeded!")
@@ -120,28 +147,30 @@ def main(args):
         print(f"\n================================ Make ================================")
 
         if (asyncio.run(create_coroutine(lambda patch_coord_x, patch_coord_y: textwrap.dedent(f"""\
-            srun cmake --build build/patch_{patch_coord_x}_{patch_coord_y}
-        """))())):
+            srun cmake --build {build_directory(patch_coord_x, patch_coord_y)}
+        """), build_coords)())):
 
             print(f"\n================================ Make ================================")
             print(">>> Succeeded!")
 
             print(f"\n================================ App ================================")
 
-            if (asyncio.run(create_coroutine(lambda patch_coord_x, patch_coord_y: textwrap.dedent(f"""\
-                srun build/patch_{patch_coord_x}_{patch_coord_y}/ray_tracing
-            """))())):
+            if (asyncio.run(create_coroutine(program)())):
 
                 print(f"\n================================ App ================================")
                 print(">>> Succeeded!")
 
-                image = np.concatenate([
-                    np.concatenate([
-                        skimage.io.imread(f"outputs/patch_{patch_coord_x}_{patch_coord_y}.ppm")
-                        for patch_coord_x in range(args.image_width // args.patch_width)
-                    ], axis=1)
-                    for patch_coord_y in range(args.image_height // args.patch_height)
-                ], axis=0)
+                # at run time, every patch has encoded itself into its region of the memory-mapped image
+                if args.constexpr:
+                    image = np.concatenate([
+                        np.concatenate([
+                            skimage.io.imread(f"outputs/patch_{patch_coord_x}_{patch_coord_y}.ppm")
+                            for patch_coord_x in range(args.image_width // args.patch_width)
+                        ], axis=1)
+                        for patch_coord_y in range(args.image_height // args.patch_height)
+                    ], axis=0)
+                else:
+                    image = skimage.io.imread("outputs/image.ppm")
 
                 skimage.io.imsave(f"outputs/image.png", image)
 
@@ -165,6 +194,7 @@ if __name__ == "__main__":
 
     parser = argparse.ArgumentParser(description="Separate Compilation Script")
     parser.add_argument("--constexpr", action="store_true", help="whether to enable compile-time ray tracing")
+    parser.add_argument("--scalar", choices=["double", "float"], default="double", help="floating-point type of the renderer")
     parser.add_argument("--image_width", type=int, default=600, help="width of the image")
     parser.add_argument("--image_height", type=int, default=400, help="height of the image")
     parser.add_argument("--patch_width", type=int, default=10, help="width of each patch")
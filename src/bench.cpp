@@ -0,0 +1,191 @@
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <complex>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "camera.hpp"
+#include "geometry.hpp"
+#include "packed_vector.hpp"
+#include "random.hpp"
+#include "reflection.hpp"
+#include "scene.hpp"
+#include "tensor.hpp"
+
+int main(int argc, char *argv[]) {
+    namespace po = boost::program_options;
+
+    po::options_description description("Ray Tracing Microbenchmarks");
+    description.add_options()("help,h", "show this help message and exit")(
+        "filter", po::value<std::string>()->default_value(""), "run only the benchmarks whose name contains this")(
+        "cpu", po::value<int>()->default_value(0), "CPU to pin the benchmarks to (-1: do not pin)")(
+        "num_runs", po::value<std::size_t>()->default_value(30), "number of timed runs per benchmark")(
+        "run_time", po::value<double>()->default_value(10.0), "duration of each timed run, in milliseconds")(
+        "warm_up_time", po::value<double>()->default_value(100.0),
+        "duration of the warm-up of each benchmark, in milliseconds");
+
+    po::variables_map variables;
+    try {
+        po::store(po::parse_command_line(argc, argv, description), variables);
+        po::notify(variables);
+    } catch (const po::error &error) {
+        std::cerr << error.what() << std::endl << description << std::endl;
+        return 1;
+    }
+
+    if (variables.count("help")) {
+        std::cout << description << std::endl;
+        return 0;
+    }
+
+    auto cpu = variables["cpu"].as<int>();
+    if (cpu >= 0 && !coex::benchmark::pin_to_cpu(cpu)) std::cerr << "failed to pin to CPU " << cpu << std::endl;
+
+    coex::benchmark::Options options{
+        std::chrono::duration<double, std::milli>(variables["warm_up_time"].as<double>()),
+        std::chrono::duration<double, std::milli>(variables["run_time"].as<double>()),
+        variables["num_runs"].as<std::size_t>(),
+    };
+
+    // Inputs are drawn once from a fixed seed, so that every run times the same work, and cycled through by the
+    // iterations, so that the compiler cannot fold them.
+    constexpr std::size_t num_inputs = 1 << 10;
+    auto input = [](auto iteration_index) { return iteration_index % num_inputs; };
+
+    coex::random::Philox<> generator(__LINE__);
+
+    std::vector<coex::tensor::Vector<Scalar, 3>> vectors(num_inputs);
+    std::vector<coex::tensor::Matrix<Scalar, 3, 3>> matrices(num_inputs);
+    std::vector<coex::camera::Ray<Scalar>> rays(num_inputs);
+    std::vector<coex::tensor::Vector<Scalar, 3>> positions(num_inputs);
+    // rays arriving at points of the unit sphere, with the normals there
+    std::vector<coex::camera::Ray<Scalar>> incident_rays(num_inputs);
+    std::vector<coex::tensor::Vector<Scalar, 3>> normals(num_inputs);
+    for (std::size_t index = 0; index < num_inputs; ++index) {
+        vectors[index] = coex::random::uniform_in_unit_sphere<Scalar, coex::tensor::Vector>(generator);
+        for (auto &row : matrices[index]) {
+            row = coex::random::uniform_in_unit_sphere<Scalar, coex::tensor::Vector>(generator);
+        }
+        auto coord_u = coex::random::uniform(generator, 0.0, 1.0);
+        auto coord_v = coex::random::uniform(generator, 0.0, 1.0);
+        rays[index] = camera.ray(coord_u, coord_v, generator);
+        positions[index] = coex::random::uniform_in_unit_sphere<Scalar, coex::tensor::Vector>(generator) * 12.0;
+        normals[index] = coex::random::uniform_on_unit_sphere<Scalar, coex::tensor::Vector>(generator);
+        auto offset = coex::random::uniform_in_unit_sphere<Scalar, coex::tensor::Vector>(generator);
+        incident_rays[index] =
+            coex::camera::Ray<Scalar>(normals[index], coex::tensor::normalized(offset - normals[index]));
+    }
+
+    // the glass sphere at the center of the scene
+    coex::geometry::Sphere<Scalar, coex::tensor::Vector, coex::reflection::Dielectric> sphere(
+        1.0, coex::tensor::Vector<Scalar, 3>{0.0, -1.0, 0.0},
+        coex::reflection::Dielectric<Scalar, coex::tensor::Vector>(coex::tensor::Vector<Scalar, 3>{1.0, 1.0, 1.0},
+                                                                   1.5));
+    coex::reflection::Lambertian<Scalar, coex::tensor::Vector> lambertian(
+        coex::tensor::Vector<Scalar, 3>{0.5, 0.5, 0.5});
+    coex::reflection::Metal<Scalar, coex::tensor::Vector> metal(
+        coex::tensor::Vector<std::complex<Scalar>, 3>{std::complex<Scalar>(0.18299, 3.42420),
+                                                      std::complex<Scalar>(0.42108, 2.34590),
+                                                      std::complex<Scalar>(1.37340, 1.77040)},
+        0.1);
+    coex::reflection::Dielectric<Scalar, coex::tensor::Vector> dielectric(
+        coex::tensor::Vector<Scalar, 3>{1.0, 1.0, 1.0}, 1.5);
+    coex::random::LCG<> lcg(__LINE__);
+
+    // a tile of radiance as a contiguous tensor
+    coex::tensor::DynamicTensor<Scalar, 3> tile({64, 64, 3});
+    for (std::size_t index = 0; index < tile.size(); ++index) {
+        tile.data()[index] = vectors[index / 3 % num_inputs][index % 3];
+    }
+
+    auto filter = variables["filter"].as<std::string>();
+    std::printf("%-32s %12s %12s %12s %12s %12s\n", "benchmark", "ns/op", "+/- (95%)", "median", "min", "iterations");
+    auto benchmark = [&](const std::string &name, auto &&function) {
+        if (name.find(filter) == std::string::npos) return;
+        auto result = coex::benchmark::run(name, function, options);
+        std::printf("%-32s %12.3f %12.3f %12.3f %12.3f %12zu\n", result.name.c_str(), result.mean, result.confidence,
+                    result.median, result.min, result.num_iterations);
+    };
+
+    // geometry
+    benchmark("sphere/intersect", [&](auto index) { return sphere.intersect(rays[input(index)]); });
+    benchmark("sphere/intersect_distance", [&](auto index) { return sphere.intersect_distance(rays[input(index)]); });
+#ifdef RAY_TRACING_PACKED_VECTOR
+    benchmark("sphere/intersect_distance_packed", [&](auto index) {
+        return coex::benchmark::packed::intersect_distance(sphere.position(), sphere.radius(), rays[input(index)]);
+    });
+#endif
+    benchmark("sphere/distance", [&](auto index) { return sphere.distance(positions[input(index)]); });
+    benchmark("csg/intersect", [&](auto index) { return object.intersect(rays[input(index)]); });
+    benchmark("csg/distance", [&](auto index) { return object.distance(positions[input(index)]); });
+    benchmark("bvh/intersect", [&](auto index) { return bvh.intersect(rays[input(index)]); });
+
+    // camera
+    benchmark("camera/ray", [&](auto index) {
+        auto coord = vectors[input(index)];
+        return camera.ray(coord[0] * 0.5 + 0.5, coord[1] * 0.5 + 0.5, generator);
+    });
+
+    // materials
+    benchmark("reflection/lambertian",
+              [&](auto index) { return lambertian(incident_rays[input(index)], normals[input(index)], generator); });
+    benchmark("reflection/metal",
+              [&](auto index) { return metal(incident_rays[input(index)], normals[input(index)], generator); });
+    benchmark("reflection/dielectric",
+              [&](auto index) { return dielectric(incident_rays[input(index)], normals[input(index)], generator); });
+
+    // random
+    benchmark("random/philox", [&](auto) { return generator(); });
+    benchmark("random/lcg", [&](auto) { return lcg(); });
+    benchmark("random/philox_seek", [&](auto index) {
+        return coex::random::Philox<>(__LINE__, static_cast<std::uint32_t>(index), 0, 0)();
+    });
+    benchmark("random/uniform", [&](auto) { return coex::random::uniform(generator, 0.0, 1.0); });
+    benchmark("random/uniform_in_unit_circle",
+              [&](auto) { return coex::random::uniform_in_unit_circle<Scalar, coex::tensor::Vector>(generator); });
+    benchmark("random/uniform_in_unit_sphere",
+              [&](auto) { return coex::random::uniform_in_unit_sphere<Scalar, coex::tensor::Vector>(generator); });
+    benchmark("random/uniform_on_unit_sphere",
+              [&](auto) { return coex::random::uniform_on_unit_sphere<Scalar, coex::tensor::Vector>(generator); });
+
+    // tensor
+    auto other = [&](auto index) { return input(index + num_inputs / 2); };
+    benchmark("tensor/add", [&](auto index) { return vectors[input(index)] + vectors[other(index)]; });
+    benchmark("tensor/multiply", [&](auto index) { return vectors[input(index)] * vectors[other(index)]; });
+    benchmark("tensor/scale", [&](auto index) { return vectors[input(index)] * Scalar(1.5); });
+    benchmark("tensor/dot",
+              [&](auto index) { return coex::tensor::dot(vectors[input(index)], vectors[other(index)]); });
+    benchmark("tensor/cross",
+              [&](auto index) { return coex::tensor::cross(vectors[input(index)], vectors[other(index)]); });
+    benchmark("tensor/normalized", [&](auto index) { return coex::tensor::normalized(vectors[input(index)]); });
+#ifdef RAY_TRACING_PACKED_VECTOR
+    benchmark("tensor/normalized_packed",
+              [&](auto index) { return coex::benchmark::packed::normalized(vectors[input(index)]); });
+#endif
+    // a walk of normalized steps, as the bounces of a path chain them
+    constexpr std::size_t num_steps = 8;
+    benchmark("tensor/axpy_chain", [&](auto index) {
+        auto position = vectors[input(index)];
+        for (std::size_t step = 1; step <= num_steps; ++step) {
+            position = coex::tensor::normalized(Scalar(0.5) * vectors[input(index + step)] + position);
+        }
+        return position;
+    });
+#ifdef RAY_TRACING_PACKED_VECTOR
+    benchmark("tensor/axpy_chain_packed", [&](auto index) {
+        auto position = vectors[input(index)];
+        for (std::size_t step = 1; step <= num_steps; ++step) {
+            position = coex::benchmark::packed::normalized(
+                coex::benchmark::packed::axpy(Scalar(0.5), vectors[input(index + step)], position));
+        }
+        return position;
+    });
+#endif
+    benchmark("tensor/matrix_vector", [&](auto index) { return matrices[input(index)] % vectors[other(index)]; });
+    benchmark("tensor/dynamic_add", [&](auto) { return tile + tile; });
+    benchmark("tensor/dynamic_sum", [&](auto) { return coex::tensor::sum(tile); });
+    benchmark("tensor/dynamic_dot", [&](auto) { return coex::tensor::dot(tile, tile); });
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <sched.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace coex::benchmark {
+
+// Keep the compiler from discarding a value or hoisting its computation out of the timed loop.
+template <typename T>
+inline void do_not_optimize(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Pin the calling thread to one CPU, so that timings do not suffer from migrations. Returns whether it succeeded.
+inline auto pin_to_cpu(int cpu) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    return ::sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+}
+
+struct Options {
+    std::chrono::duration<double> warm_up_time{0.1};
+    std::chrono::duration<double> run_time{0.01};  // duration of each timed run
+    std::size_t num_runs = 30;
+};
+
+// Nanoseconds per operation over the timed runs, with the half-width of the 95% confidence interval of the mean.
+struct Result {
+    std::string name;
+    std::size_t num_iterations;  // per run
+    double mean;
+    double confidence;
+    double median;
+    double min;
+};
+
+// two-sided 95% quantile of Student's t distribution, by its Cornish-Fisher expansion around the normal one
+inline auto t_quantile(std::size_t degrees_of_freedom) {
+    auto z = 1.959964;
+    auto n = static_cast<double>(degrees_of_freedom);
+    return z + (z * z * z + z) / (4 * n) + (5 * std::pow(z, 5) + 16 * z * z * z + 3 * z) / (96 * n * n);
+}
+
+// Time `function(iteration_index)`, whose result is kept from being optimized away. The number of iterations per run
+// is calibrated during the warm-up, so that every run lasts about `run_time`.
+inline auto run(const std::string &name, auto &&function, const Options &options = {}) {
+    using Clock = std::chrono::steady_clock;
+
+    auto time = [&](std::size_t num_iterations) {
+        auto start = Clock::now();
+        for (std::size_t iteration_index = 0; iteration_index < num_iterations; ++iteration_index) {
+            do_not_optimize(function(iteration_index));
+        }
+        return std::chrono::duration<double>(Clock::now() - start);
+    };
+
+    std::size_t num_iterations = 1;
+    for (auto warm_up_start = Clock::now(); Clock::now() - warm_up_start < options.warm_up_time;) {
+        auto elapsed = time(num_iterations);
+        if (elapsed < options.run_time) {
+            auto scale = elapsed.count() > 0 ? options.run_time / elapsed : 10.0;
+            num_iterations =
+                std::max(num_iterations + 1, static_cast<std::size_t>(num_iterations * std::min(scale, 10.0)));
+        }
+    }
+
+    std::vector<double> samples(options.num_runs);
+    for (auto &sample : samples) {
+        sample = std::chrono::duration<double, std::nano>(time(num_iterations)).count() / num_iterations;
+    }
+
+    auto mean = std::accumulate(std::begin(samples), std::end(samples), 0.0) / samples.size();
+    auto squared_deviation =
+        std::accumulate(std::begin(samples), std::end(samples), 0.0,
+                        [&](auto sum, auto sample) { return sum + (sample - mean) * (sample - mean); });
+    auto confidence = samples.size() > 1 ? t_quantile(samples.size() - 1) *
+                                               std::sqrt(squared_deviation / (samples.size() - 1) / samples.size())
+                                         : 0.0;
+
+    std::sort(std::begin(samples), std::end(samples));
+    auto median = samples.size() % 2 ? samples[samples.size() / 2]
+                                     : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+
+    return Result{name, num_iterations, mean, confidence, median, samples.front()};
+}
+
+}  // namespace coex::benchmark
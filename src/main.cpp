@@ -1,15 +1,444 @@
+#include <array>
+#include <boost/program_options.hpp>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
 #include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <ranges>
 #include <string>
+#include <thread>
+#include <variant>
 
 #include "image.hpp"
 #include "math.hpp"
+#include "parallel.hpp"
 #include "rendering.hpp"
 #include "scene.hpp"
 #include "tensor.hpp"
 
-int main() {
+#if !IS_CONSTANT_EVALUATED
+namespace {
+
+using namespace std::literals::string_literals;
+namespace po = boost::program_options;
+
+// The compile-time parameters only serve as defaults here, so one build can render any patch.
+auto make_description() {
+    po::options_description description("Runtime Ray Tracing");
+    description.add_options()("help,h", "show this help message and exit")(
+        "image_width", po::value<std::size_t>()->default_value(IMAGE_WIDTH), "width of the image")(
+        "image_height", po::value<std::size_t>()->default_value(IMAGE_HEIGHT), "height of the image")(
+        "patch_width", po::value<std::size_t>()->default_value(PATCH_WIDTH), "width of each patch")(
+        "patch_height", po::value<std::size_t>()->default_value(PATCH_HEIGHT), "height of each patch")(
+        "patch_coord_x", po::value<std::size_t>()->default_value(PATCH_COORD_X), "x-coordinate of the patch")(
+        "patch_coord_y", po::value<std::size_t>()->default_value(PATCH_COORD_Y), "y-coordinate of the patch")(
+        "max_depth", po::value<std::size_t>()->default_value(MAX_DEPTH), "maximum depth for recursive ray tracing")(
+        "num_samples", po::value<std::size_t>()->default_value(NUM_SAMPLES),
+        "number of samples for SSAA (Super-Sampling Anti-Aliasing)")(
+        "random_seed", po::value<std::uint64_t>()->default_value(RANDOM_SEED),
+        "random seed for Monte Carlo approximation")(
+        "relative_error", po::value<double>()->default_value(0.0),
+        "relative standard error at which adaptive sampling stops a pixel (0: take num_samples samples everywhere)")(
+        "min_samples", po::value<std::size_t>()->default_value(16), "minimum number of samples for adaptive sampling")(
+        "max_samples", po::value<std::size_t>()->default_value(0),
+        "maximum number of samples per pixel for adaptive sampling, which spends the samples that converged pixels "
+        "saved out of num_samples per pixel on the noisiest ones (0: num_samples)")(
+        "sample_count_output", po::value<std::string>(), "filename of an optional PGM image of the sample counts")(
+        "wavefront", po::bool_switch(),
+        "whether to trace paths breadth-first in material-sorted waves (takes num_samples samples everywhere)")(
+        "ray_packets", po::bool_switch(), "whether the wavefront integrator intersects primary rays in SIMD packets")(
+        "accelerator", po::value<std::string>()->default_value("bvh"),
+        "acceleration structure for nearest hits (bvh: a bounding volume hierarchy, arena: a flattened sphere arena, "
+        "none: the CSG tree itself)")(
+        "ray_marching", po::bool_switch(),
+        "whether to render by sphere tracing the distance field of the scene (takes precedence over wavefront)")(
+        "max_step", po::value<std::size_t>()->default_value(1000), "maximum number of ray marching steps per ray")(
+        "epsilon", po::value<double>()->default_value(1e-4), "distance at which ray marching hits a surface")(
+        "relaxation", po::value<double>()->default_value(1.6),
+        "factor by which ray marching over-relaxes its steps (1: plain sphere tracing)")(
+        "pixel_epsilon", po::value<double>()->default_value(0.5),
+        "distance at which ray marching hits a surface relative to the pixel footprint there, if above epsilon")(
+        "distance_cache", po::bool_switch(),
+        "whether ray marching steps through empty space by a brick map of the distance field")(
+        "cache_resolution", po::value<std::size_t>()->default_value(256),
+        "number of cells of the distance cache along the longest axis of the scene")(
+        "russian_roulette", po::bool_switch(), "whether to terminate paths by Russian roulette on their throughput")(
+        "roulette_depth", po::value<std::size_t>()->default_value(3), "depth from which Russian roulette applies")(
+        "num_threads", po::value<std::size_t>()->default_value(0),
+        "number of worker threads per process (0: all hardware threads, shared out among the worker processes)")(
+        "num_processes", po::value<std::size_t>()->default_value(0),
+        "number of worker processes rendering the whole image (0: render the patch in this process)")(
+        "tile_width", po::value<std::size_t>()->default_value(64), "width of each tile handed out to the processes")(
+        "tile_height", po::value<std::size_t>()->default_value(64), "height of each tile handed out to the processes")(
+        "output", po::value<std::string>(),
+        "output filename (default: outputs/patch_<x>_<y>.<format>, or outputs/image.<format> with processes)")(
+        "checkpoint", po::value<std::string>(),
+        "filename of the per-pixel accumulators of the image, which the render resumes from and updates, so that it "
+        "can go on after being killed or be refined to more samples (not with wavefront)")(
+        "checkpoint_interval", po::value<double>()->default_value(60.0),
+        "interval in seconds at which the checkpoint is written to disk")(
+        "progress", po::value<std::string>(),
+        "file to write the progress and throughput of the render to as JSON lines, or fd:<n> for an open file "
+        "descriptor")(
+        "progress_interval", po::value<double>()->default_value(1.0), "interval in seconds between progress lines")(
+        "image_output", po::value<std::string>(),
+        "filename of the whole image, which the patch or the tiles encode themselves into through a memory mapping "
+        "instead of writing the output file (not with the ascii format)")(
+        "format", po::value<std::string>()->default_value("ppm"),
+        "output format (ppm: 8-bit binary PPM, ppm16: 16-bit binary PPM, pfm: linear floating-point PFM, ascii: 8-bit "
+        "ASCII PPM)")(
+        "profile", po::bool_switch(),
+        "whether to count the work of every pixel of the image as the compile-time build renders it and plan the patch "
+        "sizes of that build instead of rendering")(
+        "plan_samples", po::value<std::size_t>()->default_value(NUM_SAMPLES),
+        "number of samples per pixel of the compile-time build to plan for (the profile takes num_samples)")(
+        "ops_limit", po::value<double>()->default_value(4294967295.0),
+        "-fconstexpr-ops-limit of the compile-time build")(
+        "memory_budget", po::value<double>()->default_value(16384.0),
+        "memory that compiling each patch may take, in MiB");
+
+    return description;
+}
+
+// Settings of the patch given by the options, or none if it lies outside of the image. Patches on the right and
+// bottom edges are clipped to the image.
+std::optional<coex::rendering::Settings> parse_settings(const po::variables_map &variables) {
+    auto image_width = variables["image_width"].as<std::size_t>();
+    auto image_height = variables["image_height"].as<std::size_t>();
+    auto patch_width = variables["patch_width"].as<std::size_t>();
+    auto patch_height = variables["patch_height"].as<std::size_t>();
+    auto patch_coord_x = variables["patch_coord_x"].as<std::size_t>();
+    auto patch_coord_y = variables["patch_coord_y"].as<std::size_t>();
+
+    if (patch_width * patch_coord_x >= image_width || patch_height * patch_coord_y >= image_height) {
+        std::cerr << "the patch lies outside of the image" << std::endl;
+        return std::nullopt;
+    }
+
+    return coex::rendering::Settings{
+        image_width,
+        image_height,
+        {patch_width * patch_coord_x, patch_height * patch_coord_y,
+         std::min(patch_width, image_width - patch_width * patch_coord_x),
+         std::min(patch_height, image_height - patch_height * patch_coord_y)},
+        variables["max_depth"].as<std::size_t>(),
+        variables["num_samples"].as<std::size_t>(),
+        variables["random_seed"].as<std::uint64_t>(),
+        variables["relative_error"].as<double>(),
+        variables["min_samples"].as<std::size_t>(),
+        variables["max_samples"].as<std::size_t>(),
+        variables["russian_roulette"].as<bool>(),
+        variables["roulette_depth"].as<std::size_t>(),
+        variables["ray_packets"].as<bool>(),
+        variables["num_threads"].as<std::size_t>(),
+    };
+}
+
+// Count the work of every pixel of the image as the compile-time build renders it, and list the patch sizes that keep
+// the build within its limits. Returns the exit status.
+int run_profile(const po::variables_map &variables, coex::rendering::Settings settings) {
+    settings.patch = {0, 0, settings.image_width, settings.image_height};
+    auto profiles = coex::rendering::profile_ray_tracing<Scalar>(bvh, materials, camera, background, settings);
+
+    const auto &model = coex::rendering::gcc_cost_model;
+    auto plan_samples = variables["plan_samples"].as<std::size_t>();
+    auto sample_ratio = static_cast<double>(plan_samples) / static_cast<double>(settings.num_samples);
+
+    coex::rendering::PixelProfile total;
+    double max_ops = 0;
+    for (const auto &profile : profiles) {
+        total += profile;
+        max_ops = std::max(max_ops, model.ops(profile, sample_ratio));
+    }
+    auto num_paths = static_cast<double>(total.num_paths);
+    std::cout << "per path: " << total.num_rays / num_paths << " rays, " << total.num_node_visits / num_paths
+              << " node visits, " << total.num_primitive_tests / num_paths << " primitive tests" << std::endl;
+    std::cout << "constexpr ops per pixel at " << plan_samples
+              << " samples: " << model.ops(total, sample_ratio) / profiles.size() << " on average, " << max_ops
+              << " at most" << std::endl;
+
+    auto mebibyte = 1024.0 * 1024.0;
+    auto plans = coex::rendering::plan_patches(profiles, settings.image_width, settings.image_height, model,
+                                               sample_ratio, variables["ops_limit"].as<double>(),
+                                               variables["memory_budget"].as<double>() * mebibyte);
+    if (plans.empty()) {
+        std::cerr << "no patch size keeps every patch within the limits" << std::endl;
+        return 1;
+    }
+    for (const auto &plan : plans | std::views::take(10)) {
+        std::cout << "--patch_width " << plan.patch_width << " --patch_height " << plan.patch_height << ": "
+                  << plan.num_patches << " patches, up to " << plan.max_ops << " ops and "
+                  << plan.max_bytes / mebibyte << " MiB" << std::endl;
+    }
+    return 0;
+}
+
+// What a render stores its pixels and tiles into as they finish, besides its result: the whole image file, the
+// checkpoint and the progress, each if asked for. None of them can be moved, so they are opened in place.
+struct RenderOutputs {
+    std::variant<std::monostate, coex::image::MappedImage<std::uint8_t>, coex::image::MappedImage<std::uint16_t>,
+                 coex::image::MappedImage<float>>
+        mapped_image;
+    std::optional<coex::rendering::Checkpoint> checkpoint;
+    std::chrono::duration<double> checkpoint_interval{};
+    std::optional<coex::rendering::Progress> progress;
+    std::optional<coex::rendering::ProgressReporter> progress_reporter;
+
+    auto write_region(const auto &region, const auto &colors) {
+        std::visit(coex::Overloaded{[](std::monostate) {},
+                                    [&](auto &mapped_image) { mapped_image.write(region, colors); }},
+                   mapped_image);
+    }
+};
+
+// With an image output, the whole image file is mapped before any worker is forked, and every patch or tile is
+// encoded straight into its region of it. Returns whether it succeeded.
+bool open_mapped_image(const po::variables_map &variables, const coex::rendering::Settings &settings,
+                       const std::string &format, RenderOutputs &outputs) {
+    if (!variables.count("image_output")) return true;
+
+    std::filesystem::path filename = variables["image_output"].as<std::string>();
+    if (filename.has_parent_path()) std::filesystem::create_directories(filename.parent_path());
+    if (format == "ppm") {
+        outputs.mapped_image.emplace<1>(filename, settings.image_width, settings.image_height);
+    } else if (format == "ppm16") {
+        outputs.mapped_image.emplace<2>(filename, settings.image_width, settings.image_height);
+    } else if (format == "pfm") {
+        outputs.mapped_image.emplace<3>(filename, settings.image_width, settings.image_height);
+    } else {
+        std::cerr << "the ascii format cannot be memory-mapped" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Finished pixels are stored into the mapped checkpoint at once, so that they outlive a killed process, and are
+// written to disk from time to time. Returns whether it succeeded.
+bool open_checkpoint(const po::variables_map &variables, coex::rendering::Settings &settings, RenderOutputs &outputs) {
+    outputs.checkpoint_interval = std::chrono::duration<double>(variables["checkpoint_interval"].as<double>());
+    if (!variables.count("checkpoint")) return true;
+
+    auto ray_marching = variables["ray_marching"].as<bool>();
+    if (variables["wavefront"].as<bool>() && !ray_marching) {
+        std::cerr << "the wavefront integrator cannot resume from a checkpoint" << std::endl;
+        return false;
+    }
+    auto use_distance_cache = ray_marching && variables["distance_cache"].as<bool>();
+    // the shortest digits that read back as the same value, so that parameters differing in any digit differ in key
+    auto to_string = [](double value) {
+        std::array<char, 32> buffer;
+        return std::string(buffer.data(), std::to_chars(buffer.data(), buffer.data() + buffer.size(), value).ptr);
+    };
+    auto integrator =
+        ray_marching ? "ray_marching "s + std::to_string(variables["max_step"].as<std::size_t>()) + " " +
+                           to_string(variables["epsilon"].as<double>()) + " " +
+                           to_string(variables["relaxation"].as<double>()) + " " +
+                           to_string(variables["pixel_epsilon"].as<double>()) + " " +
+                           std::to_string(use_distance_cache ? variables["cache_resolution"].as<std::size_t>() : 0)
+                     : "ray_tracing"s;
+    std::filesystem::path filename = variables["checkpoint"].as<std::string>();
+    if (filename.has_parent_path()) std::filesystem::create_directories(filename.parent_path());
+    try {
+        outputs.checkpoint.emplace(filename, coex::rendering::make_checkpoint_key<Scalar>(settings, integrator));
+    } catch (const std::exception &exception) {
+        std::cerr << exception.what() << std::endl;
+        return false;
+    }
+    settings.accumulators = outputs.checkpoint->accumulators();
+    return true;
+}
+
+// Tiles store their counts into the progress as they finish, which the reporter writes out. The tiles are those of
+// the whole image handed out to the processes, or those render_tiles splits the patch into. Returns whether it
+// succeeded.
+bool start_progress(const po::variables_map &variables, coex::rendering::Settings &settings, RenderOutputs &outputs) {
+    if (!variables.count("progress")) return true;
+
+    auto num_processes = variables["num_processes"].as<std::size_t>();
+    std::vector<coex::parallel::Tile> tiles;
+    if (num_processes) {
+        tiles = coex::parallel::split_tiles(settings.image_width, settings.image_height,
+                                            variables["tile_width"].as<std::size_t>(),
+                                            variables["tile_height"].as<std::size_t>());
+    } else {
+        tiles = coex::parallel::split_tiles(settings.patch.width, settings.patch.height, coex::parallel::tile_width,
+                                            coex::parallel::tile_height);
+        for (auto &tile : tiles) {
+            tile.x += settings.patch.x;
+            tile.y += settings.patch.y;
+        }
+    }
+    outputs.progress.emplace(std::move(tiles));
+    if (!num_processes) settings.progress = &*outputs.progress;
+    try {
+        outputs.progress_reporter.emplace(*outputs.progress, variables["progress"].as<std::string>(),
+                                          std::chrono::duration<double>(variables["progress_interval"].as<double>()));
+    } catch (const std::exception &exception) {
+        std::cerr << exception.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Radiance, sample counts and statistics of the patch or of the whole image, indexed by (y, x), in buffers of
+// `Allocator`.
+template <template <typename> typename Allocator = coex::AlignedAllocator>
+struct Rendering {
+    using Color = coex::tensor::Vector<Scalar, 3>;
+
+    Rendering(std::size_t width, std::size_t height) : image({height, width}), sample_counts({height, width}) {}
+
+    coex::tensor::DynamicTensor<Color, 2, Allocator<Color>> image;
+    coex::tensor::DynamicTensor<std::size_t, 2, Allocator<std::size_t>> sample_counts;
+    coex::rendering::Statistics statistics;
+};
+
+// Render the whole image with `num_processes` forked workers, which take tiles of the whole image from a shared queue
+// and render them straight into buffers in shared memory; the tiles of crashed workers are reissued. Returns none if
+// some tiles kept crashing their workers.
+std::optional<Rendering<coex::parallel::SharedAllocator>> render_with_processes(const po::variables_map &variables,
+                                                                                coex::rendering::Settings settings,
+                                                                                auto &&render, RenderOutputs &outputs) {
+    auto num_processes = variables["num_processes"].as<std::size_t>();
+    auto image_width = settings.image_width;
+    auto image_height = settings.image_height;
+    settings.patch = {0, 0, image_width, image_height};
+
+    // Every worker renders its tiles on a thread pool of its own, started on its first tile, and the hardware
+    // threads are shared out among the workers unless told otherwise.
+    auto num_threads =
+        settings.num_threads
+            ? settings.num_threads
+            : std::max<std::size_t>(coex::parallel::ThreadPool::default_concurrency() / num_processes, 1);
+    std::optional<coex::parallel::ThreadPool> thread_pool;
+
+    // A child forked while other threads run would inherit whatever locks they hold, never to be released, so
+    // this process keeps no threads of its own while it forks workers: the loop that watches them flushes the
+    // checkpoint and reports the progress instead.
+    auto last_flush = std::chrono::steady_clock::now();
+    auto monitor = [&](auto) {
+        if (outputs.checkpoint && std::chrono::steady_clock::now() - last_flush >= outputs.checkpoint_interval) {
+            outputs.checkpoint->flush();
+            last_flush = std::chrono::steady_clock::now();
+        }
+        if (outputs.progress_reporter) outputs.progress_reporter->poll();
+    };
+
+    auto tiles = coex::parallel::split_tiles(image_width, image_height, variables["tile_width"].as<std::size_t>(),
+                                             variables["tile_height"].as<std::size_t>());
+    std::optional<Rendering<coex::parallel::SharedAllocator>> rendering(std::in_place, image_width, image_height);
+    coex::parallel::SharedArray<coex::rendering::Statistics> tile_statistics(tiles.size());
+    coex::parallel::ProcessPool process_pool(num_processes);
+
+    auto succeeded = process_pool.run(
+        tiles.size(),
+        [&](auto tile_index) {
+            if (!thread_pool) thread_pool.emplace(num_threads);
+            auto tile_settings = settings;
+            tile_settings.patch = tiles[tile_index];
+            tile_settings.thread_pool = &*thread_pool;
+            const auto &tile = tile_settings.patch;
+            auto [colors, sample_counts, statistics] = render(tile_settings);
+            tile_statistics[tile_index] = statistics;
+            if (outputs.progress) outputs.progress->complete(tile_index, statistics.num_paths, statistics.num_rays);
+            auto rows = colors.rows();
+            outputs.write_region(tile, rows);
+            for (std::size_t coord_y = 0; coord_y < tile.height; ++coord_y) {
+                std::copy_n(std::begin(rows) + tile.width * coord_y, tile.width,
+                            &rendering->image(tile.y + coord_y, tile.x));
+                sample_counts.read(coex::parallel::Tile{0, coord_y, tile.width, 1},
+                                   &rendering->sample_counts(tile.y + coord_y, tile.x));
+            }
+        },
+        monitor);
+
+    if (!succeeded) {
+        std::cerr << "rendering failed since some tiles kept crashing their workers" << std::endl;
+        return std::nullopt;
+    }
+
+    for (const auto &statistics : tile_statistics) {
+        rendering->statistics += statistics;
+    }
+    return rendering;
+}
+
+// Render the patch of the settings in this process, on a thread pool.
+Rendering<> render_patch(const coex::rendering::Settings &settings, auto &&render, RenderOutputs &outputs) {
+    // a background thread writes the checkpoint to disk from time to time
+    std::jthread flusher;
+    if (outputs.checkpoint) {
+        flusher = std::jthread([&](std::stop_token stop_token) {
+            std::mutex mutex;
+            std::condition_variable_any condition_variable;
+            std::unique_lock lock(mutex);
+            while (!condition_variable.wait_for(lock, stop_token, outputs.checkpoint_interval,
+                                               [&] { return stop_token.stop_requested(); })) {
+                outputs.checkpoint->flush();
+            }
+        });
+    }
+    if (outputs.progress_reporter) outputs.progress_reporter->start();
+
+    // the patch is rendered in blocks, and handed to the encoders row by row
+    auto [colors, sample_counts, statistics] = render(settings);
+    Rendering<> rendering(settings.patch.width, settings.patch.height);
+    colors.read(coex::parallel::Tile{0, 0, settings.patch.width, settings.patch.height}, std::begin(rendering.image));
+    sample_counts.read(coex::parallel::Tile{0, 0, settings.patch.width, settings.patch.height},
+                       std::begin(rendering.sample_counts));
+    rendering.statistics = statistics;
+    outputs.write_region(settings.patch, rendering.image);
+    return rendering;
+}
+
+// Write the image, unless it was encoded into the image output already, and the sample counts if asked for.
+void write_outputs(const po::variables_map &variables, const coex::rendering::Settings &settings,
+                   const std::string &format, auto &rendering, const RenderOutputs &outputs) {
+    auto &image = rendering.image;
+
+    // without an image output, the patch or the whole image is written as a file of its own
+    if (std::holds_alternative<std::monostate>(outputs.mapped_image)) {
+        auto extension = format == "pfm" ? ".pfm"s : ".ppm"s;
+        auto patch_coord_x = variables["patch_coord_x"].as<std::size_t>();
+        auto patch_coord_y = variables["patch_coord_y"].as<std::size_t>();
+        std::filesystem::path filename = variables.count("output") ? variables["output"].as<std::string>()
+                                         : variables["num_processes"].as<std::size_t>()
+                                             ? "outputs/image"s + extension
+                                             : "outputs/patch_"s + std::to_string(patch_coord_x) + "_"s +
+                                                   std::to_string(patch_coord_y) + extension;
+        if (filename.has_parent_path()) std::filesystem::create_directories(filename.parent_path());
+        // the encoders take linear radiance and gamma-correct it in bulk, except for PFM which keeps it linear
+        if (format == "ppm") {
+            coex::image::write_binary_ppm(filename, image, settings.patch.width, settings.patch.height);
+        } else if (format == "ppm16") {
+            coex::image::write_binary_ppm<std::uint16_t>(filename, image, settings.patch.width,
+                                                         settings.patch.height);
+        } else if (format == "pfm") {
+            coex::image::write_pfm(filename, image, settings.patch.width, settings.patch.height);
+        } else {
+            std::transform(std::begin(image), std::end(image), std::begin(image),
+                           [](const auto &color) { return coex::tensor::elemwise(coex::math::sqrt<Scalar>, color); });
+            coex::image::write_ppm(filename, image, settings.patch.width, settings.patch.height);
+        }
+    }
+
+    if (variables.count("sample_count_output")) {
+        std::filesystem::path filename = variables["sample_count_output"].as<std::string>();
+        if (filename.has_parent_path()) std::filesystem::create_directories(filename.parent_path());
+        coex::image::write_pgm(filename, rendering.sample_counts, settings.patch.width, settings.patch.height);
+    }
+}
+
+}  // namespace
+#endif
+
+int main(int argc, char *argv[]) {
     using namespace std::literals::string_literals;
 
+#if IS_CONSTANT_EVALUATED
     constexpr auto ImageWidth = IMAGE_WIDTH;
     constexpr auto ImageHeight = IMAGE_HEIGHT;
     constexpr auto PatchWidth = PATCH_WIDTH;
@@ -20,20 +449,117 @@ int main() {
     constexpr auto NumSamples = NUM_SAMPLES;
     constexpr auto RandomSeed = RANDOM_SEED;
 
-    CONSTEXPR auto image = [&]() constexpr {
-        // rendering
-        auto colors =
-            coex::rendering::ray_tracing<Scalar, ImageWidth, ImageHeight, PatchWidth, PatchHeight, PatchCoordX,
-                                         PatchCoordY>(object, camera, background, MaxDepth, NumSamples, RandomSeed);
-
-        // gamma correction
-        std::transform(std::begin(colors), std::end(colors), std::begin(colors),
-                       [](const auto &color) { return coex::tensor::elemwise(coex::math::sqrt<Scalar>, color); });
-        return colors;
-    }();
+    // rendering, leaving gamma correction to the encoder at run time; the patch is kept in static storage rather than
+    // copied onto the stack, whatever its size
+    static CONSTEXPR auto image =
+        coex::rendering::ray_tracing<Scalar, ImageWidth, ImageHeight, PatchWidth, PatchHeight, PatchCoordX,
+                                     PatchCoordY>(bvh, materials, camera, background, MaxDepth, NumSamples, RandomSeed);
 
     std::filesystem::path filename =
         "outputs/patch_"s + std::to_string(PatchCoordX) + "_"s + std::to_string(PatchCoordY) + ".ppm"s;
     std::filesystem::create_directories(filename.parent_path());
-    coex::image::write_ppm(filename, image, PatchWidth, PatchHeight);
+    coex::image::write_binary_ppm(filename, image, PatchWidth, PatchHeight);
+#else
+    auto description = make_description();
+
+    po::variables_map variables;
+    try {
+        po::store(po::parse_command_line(argc, argv, description), variables);
+        po::notify(variables);
+    } catch (const po::error &error) {
+        std::cerr << error.what() << std::endl << description << std::endl;
+        return 1;
+    }
+
+    if (variables.count("help")) {
+        std::cout << description << std::endl;
+        return 0;
+    }
+
+    auto parsed_settings = parse_settings(variables);
+    if (!parsed_settings) return 1;
+    auto settings = *parsed_settings;
+
+    if (variables["profile"].as<bool>()) return run_profile(variables, settings);
+
+    auto format = variables["format"].as<std::string>();
+    if (format != "ppm" && format != "ppm16" && format != "pfm" && format != "ascii") {
+        std::cerr << "unknown format: " << format << std::endl;
+        return 1;
+    }
+
+    auto accelerator = variables["accelerator"].as<std::string>();
+    if (accelerator != "bvh" && accelerator != "arena" && accelerator != "none") {
+        std::cerr << "unknown accelerator: " << accelerator << std::endl;
+        return 1;
+    }
+
+    // Every accelerator intersects packets, but only the wavefront integrator traces its rays in them.
+    if (settings.ray_packets && (!variables["wavefront"].as<bool>() || variables["ray_marching"].as<bool>())) {
+        std::cerr << "ray packets are only traced by the wavefront integrator" << std::endl;
+        return 1;
+    }
+
+    RenderOutputs outputs;
+    if (!open_mapped_image(variables, settings, format, outputs)) return 1;
+
+    // the hierarchy of the scene is built at compile time, so only the arena needs building here
+    coex::geometry::SphereArena<Scalar> arena;
+    if (accelerator == "arena") arena = coex::geometry::SphereArena<Scalar>(object);
+
+    // The distance cache only holds bounds, so it is sampled from the fastest representation of the scene whatever
+    // the accelerator, once before any worker is forked.
+    auto ray_marching = variables["ray_marching"].as<bool>();
+    auto use_distance_cache = ray_marching && variables["distance_cache"].as<bool>();
+    coex::geometry::DistanceCache<Scalar> distance_cache;
+    if (use_distance_cache) {
+        distance_cache =
+            coex::geometry::DistanceCache<Scalar>(bvh, cache_bounds, variables["cache_resolution"].as<std::size_t>());
+    }
+
+    if (!open_checkpoint(variables, settings, outputs)) return 1;
+
+    auto render = [&, wavefront = variables["wavefront"].as<bool>(), max_step = variables["max_step"].as<std::size_t>(),
+                   epsilon = variables["epsilon"].as<double>(), relaxation = variables["relaxation"].as<double>(),
+                   pixel_epsilon = variables["pixel_epsilon"].as<double>()](const auto &settings) {
+        auto integrate = [&](const auto &object) {
+            if (ray_marching) {
+                auto march = [&](const auto &object) {
+                    return coex::rendering::ray_marching<Scalar>(object, materials, camera, background, settings,
+                                                                 bounds, max_step, epsilon, relaxation, pixel_epsilon);
+                };
+                return use_distance_cache ? march(coex::geometry::cached(distance_cache, object)) : march(object);
+            }
+            return wavefront
+                       ? coex::rendering::wavefront_ray_tracing<Scalar>(object, materials, camera, background, settings)
+                       : coex::rendering::ray_tracing<Scalar>(object, materials, camera, background, settings);
+        };
+        return accelerator == "bvh" ? integrate(bvh) : accelerator == "arena" ? integrate(arena) : integrate(object);
+    };
+
+    if (!start_progress(variables, settings, outputs)) return 1;
+
+    auto finish = [&](auto &rendering) {
+        // the last line of the progress, once every tile is done
+        outputs.progress_reporter.reset();
+
+        const auto &statistics = rendering.statistics;
+        std::cout << "mean path length: " << statistics.mean_path_length() << " rays (" << statistics.num_paths
+                  << " paths)" << std::endl;
+        if (ray_marching) std::cout << "mean steps per ray: " << statistics.mean_steps_per_ray() << std::endl;
+
+        write_outputs(variables, settings, format, rendering, outputs);
+    };
+
+    // rendering
+    if (variables["num_processes"].as<std::size_t>()) {
+        auto rendering = render_with_processes(variables, settings, render, outputs);
+        if (!rendering) return 1;
+        settings.patch = {0, 0, settings.image_width, settings.image_height};
+        finish(*rendering);
+    } else {
+        auto rendering = render_patch(settings, render, outputs);
+        finish(rendering);
+    }
+#endif
 }
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <type_traits>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#include "geometry.hpp"
+#include "tensor.hpp"
+
+// The 4-lane SIMD prototype of Vector<Scalar, 3>, kept to time it against the generic tensor operations. The vectors
+// keep their packed 3-element layout, so every operation loads the components into a register with the fourth lane
+// masked off, computes there and stores them back, and dot products are fused with FMA. Only built where the target
+// has AVX2 and FMA (a Release build with -march=native on such a machine).
+
+#if defined(__AVX2__) && defined(__FMA__)
+#define RAY_TRACING_PACKED_VECTOR 1
+
+namespace coex::benchmark::packed {
+
+template <typename Scalar>
+struct Lanes;
+
+template <>
+struct Lanes<float> {
+    using Register = __m128;
+    static auto mask() { return _mm_setr_epi32(-1, -1, -1, 0); }
+    static auto load(const float *data) { return _mm_maskload_ps(data, mask()); }
+    static auto store(float *data, Register value) { _mm_maskstore_ps(data, mask(), value); }
+    static auto broadcast(float value) { return _mm_set1_ps(value); }
+    static auto add(Register lhs, Register rhs) { return _mm_add_ps(lhs, rhs); }
+    static auto subtract(Register lhs, Register rhs) { return _mm_sub_ps(lhs, rhs); }
+    static auto multiply(Register lhs, Register rhs) { return _mm_mul_ps(lhs, rhs); }
+    static auto divide(Register lhs, Register rhs) { return _mm_div_ps(lhs, rhs); }
+    static auto fused(Register lhs, Register rhs, Register addend) { return _mm_fmadd_ps(lhs, rhs, addend); }
+    static auto sum(Register value) {
+        auto pairs = _mm_add_ps(value, _mm_movehl_ps(value, value));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_movehdup_ps(pairs)));
+    }
+};
+
+template <>
+struct Lanes<double> {
+    using Register = __m256d;
+    static auto mask() { return _mm256_setr_epi64x(-1, -1, -1, 0); }
+    static auto load(const double *data) { return _mm256_maskload_pd(data, mask()); }
+    static auto store(double *data, Register value) { _mm256_maskstore_pd(data, mask(), value); }
+    static auto broadcast(double value) { return _mm256_set1_pd(value); }
+    static auto add(Register lhs, Register rhs) { return _mm256_add_pd(lhs, rhs); }
+    static auto subtract(Register lhs, Register rhs) { return _mm256_sub_pd(lhs, rhs); }
+    static auto multiply(Register lhs, Register rhs) { return _mm256_mul_pd(lhs, rhs); }
+    static auto divide(Register lhs, Register rhs) { return _mm256_div_pd(lhs, rhs); }
+    static auto fused(Register lhs, Register rhs, Register addend) { return _mm256_fmadd_pd(lhs, rhs, addend); }
+    static auto sum(Register value) {
+        auto pairs = _mm_add_pd(_mm256_castpd256_pd128(value), _mm256_extractf128_pd(value, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(pairs, _mm_unpackhi_pd(pairs, pairs)));
+    }
+};
+
+template <typename Scalar>
+using Vector = coex::tensor::Vector<Scalar, 3>;
+
+template <typename Scalar>
+auto load(const Vector<Scalar> &vector) {
+    return Lanes<Scalar>::load(vector.data());
+}
+
+template <typename Scalar>
+auto store(typename Lanes<Scalar>::Register value) {
+    Vector<Scalar> vector;
+    Lanes<Scalar>::store(vector.data(), value);
+    return vector;
+}
+
+template <typename Scalar>
+auto dot(const Vector<Scalar> &lhs, const Vector<Scalar> &rhs) {
+    return Lanes<Scalar>::sum(Lanes<Scalar>::multiply(load(lhs), load(rhs)));
+}
+
+template <typename Scalar>
+auto normalized(const Vector<Scalar> &vector) {
+    auto value = load(vector);
+    auto norm = std::sqrt(Lanes<Scalar>::sum(Lanes<Scalar>::multiply(value, value)));
+    return store<Scalar>(Lanes<Scalar>::divide(value, Lanes<Scalar>::broadcast(norm)));
+}
+
+// scale * x + y
+template <typename Scalar>
+auto axpy(Scalar scale, const Vector<Scalar> &x, const Vector<Scalar> &y) {
+    return store<Scalar>(Lanes<Scalar>::fused(Lanes<Scalar>::broadcast(scale), load(x), load(y)));
+}
+
+template <typename Scalar>
+auto subtract(const Vector<Scalar> &lhs, const Vector<Scalar> &rhs) {
+    return store<Scalar>(Lanes<Scalar>::subtract(load(lhs), load(rhs)));
+}
+
+// Sphere::intersect_distance, step for step, over the operations above.
+template <typename Scalar>
+auto intersect_distance(const Vector<Scalar> &center, Scalar radius, const auto &ray) -> std::optional<Scalar> {
+    auto direction = subtract(ray.position(), center);
+    auto a = dot(ray.direction(), ray.direction());
+    auto b = dot(ray.direction(), direction);
+    auto squared_norm = dot(direction, direction);
+    auto c = squared_norm - radius * radius;
+    auto offset = axpy(-b / a, ray.direction(), direction);
+    auto d = a * (radius * radius - dot(offset, offset));
+
+    if (d >= 0) {
+        auto root = std::sqrt(d);
+        auto q = -(b + (b < 0 ? -root : root));
+        auto distance_1 = std::abs(c) <= coex::geometry::sphere_tolerance<Scalar> * squared_norm
+                              ? -std::numeric_limits<Scalar>::infinity()
+                              : c / q;
+        auto distance_2 = q / a;
+        auto near = distance_1 < distance_2 ? distance_1 : distance_2;
+        auto far = distance_1 > distance_2 ? distance_1 : distance_2;
+        auto distance = near > 0 ? near : far;
+        if (distance > 0) return distance;
+    }
+    return {};
+}
+
+}  // namespace coex::benchmark::packed
+
+#endif
@@ -8,7 +8,7 @@
 #include "reflection.hpp"
 #include "tensor.hpp"
 
-using Scalar = double;
+using Scalar = SCALAR;
 
 // object
 inline constexpr auto object = []() constexpr {
@@ -26,9 +26,9 @@ inline constexpr auto object = []() constexpr {
                 1.0, coex::tensor::Vector<Scalar, 3>{-4.0, -1.0, 0.0},
                 coex::reflection::Metal<Scalar, coex::tensor::Vector>(
                     coex::tensor::Vector<std::complex<Scalar>, 3>{
-                        0.18299 + 3.42420i,
-                        0.42108 + 2.34590i,
-                        1.37340 + 1.77040i,
+                        std::complex<Scalar>(0.18299, 3.42420),
+                        std::complex<Scalar>(0.42108, 2.34590),
+                        std::complex<Scalar>(1.37340, 1.77040),
                     },
                     0.0)),
             coex::geometry::construct_union(
@@ -43,9 +43,9 @@ inline constexpr auto object = []() constexpr {
                         1.0, coex::tensor::Vector<Scalar, 3>{4.0, -1.0, 0.0},
                         coex::reflection::Metal<Scalar, coex::tensor::Vector>(
                             coex::tensor::Vector<std::complex<Scalar>, 3>{
-                                2.37570 + 4.26550i,
-                                2.08470 + 3.71530i,
-                                1.84530 + 3.13650i,
+                                std::complex<Scalar>(2.37570, 4.26550),
+                                std::complex<Scalar>(2.08470, 3.71530),
+                                std::complex<Scalar>(1.84530, 3.13650),
                             },
                             0.0)),
                     coex::geometry::construct_union(
@@ -59,9 +59,10 @@ inline constexpr auto object = []() constexpr {
 
                                  auto albedo = coex::tensor::elemwise(
                                      coex::math::square<Scalar>,
-                                     coex::tensor::Vector<Scalar, 3>{coex::random::uniform(generator, 0.0, 1.0),
-                                                                     coex::random::uniform(generator, 0.0, 1.0),
-                                                                     coex::random::uniform(generator, 0.0, 1.0)});
+                                     coex::tensor::Vector<Scalar, 3>{
+                                         static_cast<Scalar>(coex::random::uniform(generator, 0.0, 1.0)),
+                                         static_cast<Scalar>(coex::random::uniform(generator, 0.0, 1.0)),
+                                         static_cast<Scalar>(coex::random::uniform(generator, 0.0, 1.0))});
                                  auto refractive_index = coex::random::uniform(generator, 1.0, 2.0);
                                  coex::geometry::Sphere<Scalar, coex::tensor::Vector, coex::reflection::Lambertian>
                                      sphere(0.2, std::move(position),
@@ -86,9 +87,10 @@ inline constexpr auto object = []() constexpr {
 
                                      auto albedo = coex::tensor::elemwise(
                                          coex::math::sqrt<Scalar>,
-                                         coex::tensor::Vector<Scalar, 3>{coex::random::uniform(generator, 0.5, 1.0),
-                                                                         coex::random::uniform(generator, 0.5, 1.0),
-                                                                         coex::random::uniform(generator, 0.5, 1.0)});
+                                         coex::tensor::Vector<Scalar, 3>{
+                                             static_cast<Scalar>(coex::random::uniform(generator, 0.5, 1.0)),
+                                             static_cast<Scalar>(coex::random::uniform(generator, 0.5, 1.0)),
+                                             static_cast<Scalar>(coex::random::uniform(generator, 0.5, 1.0))});
                                      auto refractive_index = coex::random::uniform(generator, 1.0, 2.0);
                                      coex::geometry::Sphere<Scalar, coex::tensor::Vector, coex::reflection::Dielectric>
                                          sphere(0.2, std::move(position),
@@ -111,12 +113,12 @@ inline constexpr auto object = []() constexpr {
                                 auto position = coex::tensor::Vector<Scalar, 3>{center[0], -0.2, center[1]};
 
                                 coex::tensor::Vector<std::complex<Scalar>, 3> refractive_index{
-                                    coex::random::uniform(generator, 0.0, 5.0) +
-                                        coex::random::uniform(generator, 0.0, 5.0) * 1i,
-                                    coex::random::uniform(generator, 0.0, 5.0) +
-                                        coex::random::uniform(generator, 0.0, 5.0) * 1i,
-                                    coex::random::uniform(generator, 0.0, 5.0) +
-                                        coex::random::uniform(generator, 0.0, 5.0) * 1i,
+                                    std::complex<Scalar>(coex::random::uniform(generator, 0.0, 5.0) +
+                                                         coex::random::uniform(generator, 0.0, 5.0) * 1i),
+                                    std::complex<Scalar>(coex::random::uniform(generator, 0.0, 5.0) +
+                                                         coex::random::uniform(generator, 0.0, 5.0) * 1i),
+                                    std::complex<Scalar>(coex::random::uniform(generator, 0.0, 5.0) +
+                                                         coex::random::uniform(generator, 0.0, 5.0) * 1i),
                                 };
                                 auto fuzziness = coex::random::uniform(generator, 0.0, 0.5);
                                 coex::geometry::Sphere<Scalar, coex::tensor::Vector, coex::reflection::Metal> sphere(
@@ -134,6 +136,20 @@ inline constexpr auto object = []() constexpr {
                             }(std::make_index_sequence<100>{})))))));
 }();
 
+// acceleration structure over the object, built at compile time
+inline constexpr auto bvh = coex::geometry::construct_bvh<object, Scalar>();
+
+// materials of the object, indexed by the material IDs of its hits
+inline constexpr auto materials = coex::geometry::construct_material_table<object, Scalar>();
+
+// bounding sphere for ray marching, outside of which rays escape to the background
+inline constexpr auto bounds = coex::geometry::Sphere<Scalar, coex::tensor::Vector, coex::reflection::Lambertian>(
+    2000.0, coex::tensor::Vector<Scalar, 3>{0.0, 0.0, 0.0},
+    coex::reflection::Lambertian<Scalar, coex::tensor::Vector>(coex::tensor::Vector<Scalar, 3>{0.0, 0.0, 0.0}));
+
+// region over which ray marching may cache the distance field: the spheres and the ground right beneath them
+inline constexpr coex::geometry::AABB<Scalar> cache_bounds{{-13.0, -3.0, -13.0}, {13.0, 1.0, 13.0}};
+
 inline constexpr auto camera = []() constexpr {
     auto vertical_fov = 20.0 / 180.0 * std::numbers::pi;
     auto aspect_ratio = 1.5;